@@ -16,7 +16,7 @@
 #include <cstdio>
 
 extern "C" {
-#include "splay.h"
+#include "splay_bucket.h"
 }
 
 namespace {
@@ -34,7 +34,7 @@ const char* helptext =
 	"      S represents a nonempty string not containing whitespace\n\n"
 	"in N S \tInsert record (N,S) into tree (as multiset).\n"
 	"up N S \tUpdate record with key N, now associating it with S.\n"
-	"er N   \tErase one record with key N from tree (if any).\n"
+	"er N   \tErase the oldest record with key N (the one fi shows).\n"
 	"fi N   \tFind key N once, print its associated string.\n"
 	"fa N   \tFind key N in tree, print all associated strings.\n"
 	"min    \tFind and print the minimum key in the tree.\n"
@@ -69,7 +69,7 @@ void print_result(const struct splay_Result& res)
 }
 
 
-int execute_cmd(splay_Tree* tree, const std::string& cmd)
+int execute_cmd(splay_BucketTree* tree, const std::string& cmd)
 {
 	static int filenumber = 1000;
 
@@ -78,7 +78,7 @@ int execute_cmd(splay_Tree* tree, const std::string& cmd)
 		std::string s;
 		char* z;
 		if (cin >> n >> s) {
-			if (EXIT_FAILURE == splay_insert(tree, n, z=zz(s))) {
+			if (EXIT_FAILURE == splay_bucket_insert(tree, n, z=zz(s))) {
 				free(z);
 				return fail("Insertion failed");
 			}
@@ -92,7 +92,7 @@ int execute_cmd(splay_Tree* tree, const std::string& cmd)
 		std::string s;
 		char* z;
 		if (cin >> n >> s) {
-			if (EXIT_FAILURE == splay_update(tree, n, z=zz(s))) {
+			if (EXIT_FAILURE == splay_bucket_update(tree, n, z=zz(s))) {
 				free(z);
 				std::cout << "Warning: update failed\n";
 			}
@@ -105,7 +105,7 @@ int execute_cmd(splay_Tree* tree, const std::string& cmd)
 		int n;
 		void* s;
 		if (cin >> n)
-			if (EXIT_SUCCESS == splay_erase(tree, n, &s))
+			if (EXIT_SUCCESS == splay_bucket_erase(tree, n, &s))
 				free(s);
 			else
 				std::cout << "Warning: erase failed\n";
@@ -115,55 +115,48 @@ int execute_cmd(splay_Tree* tree, const std::string& cmd)
 	else if ("fi" == cmd) {
 		int n;
 		if (cin >> n)
-			print_result(splay_find(tree, n));
+			print_result(splay_bucket_find(tree, n));
 		else
 			return fail("cannot scan integer argument for command " + cmd);
 	}
-	/*
 	else if ("fa" == cmd) {
 		int n;
 		if (cin >> n) {
-			unsigned ct = rb_count_range(tree, n, n);
+			unsigned ct;
+			const splay_Satellite* ss = splay_bucket_find_all(tree, n, &ct);
 			std::cout << "Retrieving " << ct << " records\n";
-			std::vector<void*> ss(ct, NULL);
-			if (EXIT_SUCCESS == rb_read_range(tree, n, n, NULL, &ss.front()))
-				for ( ; ! ss.empty(); ss.pop_back())
-					std::cout << (char*) ss.back() << '\n';
-			else
-				return fail("unable to read range");
+			for (unsigned i = 0; i < ct; ++i)
+				std::cout << (char*) ss[i] << '\n';
 		}
 		else
 			return fail("cannot scan integer argument for command " + cmd);
 	}
-	*/
 	else if ("min" == cmd)
-		print_result(splay_min(tree));
+		print_result(splay_bucket_min(tree));
 	else if ("max" == cmd)
-		print_result(splay_max(tree));
-	/*
+		print_result(splay_bucket_max(tree));
 	else if ("pre" == cmd) {
 		int n;
 		if (cin >> n)
-			print_result(rb_find_pred(tree, n));
+			print_result(splay_bucket_find_pred(tree, n));
 		else
 			return fail("cannot scan integer argument for command " + cmd);
 	}
 	else if ("suc" == cmd) {
 		int n;
 		if (cin >> n)
-			print_result(rb_find_succ(tree, n));
+			print_result(splay_bucket_find_succ(tree, n));
 		else
 			return fail("cannot scan integer argument for command " + cmd);
 	}
-	*/
 	else if ("dot" == cmd) {
 		std::ostringstream fn;
 		fn << "tree" << ++filenumber << ".dot";
 		std::cout << "Writing to file " << fn.str() << '\n';
-		return splay_dot_output(tree, fn.str().c_str());
+		return splay_dot_output(& tree -> tree, fn.str().c_str());
 	}
 	else if ("prn" == cmd)
-		splay_debug_print_tree(tree);
+		splay_debug_print_tree(& tree -> tree);
 	else if ("help" == cmd)
 		std::cout << helptext;
 	else if ("x" == cmd)
@@ -175,13 +168,13 @@ int execute_cmd(splay_Tree* tree, const std::string& cmd)
 }
 
 
-int cleanup(int rc, struct splay_Tree* tree)
+int cleanup(int rc, struct splay_BucketTree* tree)
 {
-	for (struct splay_Result r; (r = splay_max(tree)).found; free(r.sat))
-		if (splay_erase(tree, r.key, NULL) != EXIT_SUCCESS)
+	for (void* s; tree -> size > 0; free(s))
+		if (splay_bucket_pop_max(tree, NULL, &s) != EXIT_SUCCESS)
 			return fail("Error cleaning up tree");
 
-	splay_tree_dtor(tree);
+	splay_bucket_tree_dtor(tree);
 	return EXIT_SUCCESS;
 }
 
@@ -191,10 +184,10 @@ int cleanup(int rc, struct splay_Tree* tree)
 int main(int argc, const char* const* argv)
 {
 	int rc = EXIT_SUCCESS;
-	struct splay_Tree tree;
+	struct splay_BucketTree tree;
 	std::vector<char> err_msg(4096);
 
-	if (EXIT_FAILURE == splay_tree_empty_ctor(&tree))
+	if (EXIT_FAILURE == splay_bucket_tree_ctor(&tree))
 		return fail("cannot construct tree");
 
 	std::cout << "Enter 'help' for a list of commands.\n";
@@ -204,7 +197,7 @@ int main(int argc, const char* const* argv)
 			rc = fail("Command failed");
 			break;
 		}
-		if (EXIT_FAILURE == splay_health_check(&tree,
+		if (EXIT_FAILURE == splay_health_check(&tree.tree,
 								& err_msg.front(), err_msg.size())) {
 			rc = fail("Health check failed");
 			std::cerr << & err_msg.front() << '\n';
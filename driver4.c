@@ -0,0 +1,1188 @@
+/**
+ * @file
+ * @author Andrew Predoehl
+ * @brief Test of the library API, against a brute-force model
+ *
+ * Each test applies random insertions and erasures to a tree, and the same
+ * changes to a plain array of its records, interleaved with the operations
+ * under test.  Every answer is checked against the array, and the tree must
+ * pass splay_health_check() after every step.
+ *
+ * Usage:  driver4 [operations per test]
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "splay.h"
+#include "splay_bucket.h"
+#include "splay_combine.h"
+#include "splay_forest.h"
+
+#define KEYS 100			/* keys are drawn from [0, KEYS) */
+#define MAX_RECORDS 2048
+#define BATCH 8
+#define BUCKET_KEYS 20
+#define BUCKET_MAX 64		/* records per key in the bucket test */
+#define CHAIN 1000000		/* length of the chain in the deep-tree test */
+
+/*	The model:  the records in no particular order.  Every satellite value
+	is a distinct serial number, so a record can be identified by it. */
+struct Model {
+	splay_Key key[MAX_RECORDS];
+	size_t sat[MAX_RECORDS];
+	unsigned size;
+	size_t serial;				/* last satellite value issued */
+};
+
+/*	Allocator that counts its live blocks, and fails once its budget of
+	allocations is spent. */
+struct Counting {
+	unsigned live, budget;
+};
+
+static unsigned errors = 0;
+
+static
+void check(int ok, const char* what)
+{
+	if (! ok) {
+		fprintf(stderr, "Error: %s\n", what);
+		errors += 1;
+	}
+}
+
+/* Small linear congruential generator, so runs are repeatable. */
+static
+unsigned next_random(unsigned long* seed)
+{
+	*seed = (*seed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+	return (unsigned) (*seed >> 8);
+}
+
+static
+void check_health(const struct splay_Tree* t, const char* what)
+{
+	char buf[256];
+
+	if (splay_health_check(t, buf, sizeof buf)) {
+		fprintf(stderr, "%s\n", buf);
+		check(0, what);
+	}
+}
+
+static
+int key_cmp(const void* a, const void* b)
+{
+	splay_Key ka = *(const splay_Key*) a, kb = *(const splay_Key*) b;
+	return ka < kb ? -1 : kb < ka;
+}
+
+static
+void model_add(struct Model* m, splay_Key k, size_t sat)
+{
+	m -> key[m -> size] = k;
+	m -> sat[m -> size] = sat;
+	m -> size += 1;
+}
+
+/* Index of the record (k, sat), or the size of the model if there is none. */
+static
+unsigned model_find(const struct Model* m, splay_Key k, size_t sat)
+{
+	unsigned i;
+
+	for (i = 0; i < m -> size; ++i)
+		if (m -> key[i] == k && m -> sat[i] == sat)
+			break;
+	return i;
+}
+
+/* Remove the record (k, sat); false if there is none. */
+static
+int model_remove(struct Model* m, splay_Key k, size_t sat)
+{
+	unsigned i = model_find(m, k, sat);
+
+	if (i == m -> size)
+		return 0;
+	m -> size -= 1;
+	m -> key[i] = m -> key[m -> size];
+	m -> sat[i] = m -> sat[m -> size];
+	return 1;
+}
+
+/* Number of records with keys in [lo, hi]. */
+static
+unsigned model_count(const struct Model* m, splay_Key lo, splay_Key hi)
+{
+	unsigned i, n = 0;
+
+	for (i = 0; i < m -> size; ++i)
+		n += lo <= m -> key[i] && m -> key[i] <= hi;
+	return n;
+}
+
+/*	Does the result agree with the model's nearest key to k, below or above
+	it, counting k itself if inclusive is set?  The record must exist too. */
+static
+int model_nearest(const struct Model* m, splay_Key k, int below, int inclusive,
+					struct splay_Result r)
+{
+	unsigned i;
+	int found = 0;
+	splay_Key best = 0;
+
+	for (i = 0; i < m -> size; ++i) {
+		splay_Key x = m -> key[i];
+		if (below ? (x < k || (inclusive && x == k)) && (! found || best < x)
+				: (k < x || (inclusive && x == k)) && (! found || x < best)) {
+			best = x;
+			found = 1;
+		}
+	}
+	return r.found == found && (! found || (r.key == best
+					&& model_find(m, r.key, (size_t) r.sat) < m -> size));
+}
+
+/*	One random insertion or erasure, applied to the tree and the model.
+	Insertions are likelier, so the tree grows slowly. */
+static
+void churn(struct splay_Tree* t, struct Model* m, unsigned long* seed)
+{
+	splay_Key k = (splay_Key) (next_random(seed) % KEYS);
+	splay_Satellite sat;
+	unsigned j;
+
+	if (next_random(seed) % 5 < 3 && m -> size < MAX_RECORDS) {
+		check(EXIT_SUCCESS == splay_insert(t, k, (void*) ++m -> serial),
+				"insert");
+		model_add(m, k, m -> serial);
+	}
+	else {
+		j = model_count(m, k, k);
+		check(splay_erase(t, k, &sat) == (j ? EXIT_SUCCESS : EXIT_FAILURE)
+				&& (! j || model_remove(m, k, (size_t) sat)), "erase");
+	}
+	check(t -> size == m -> size, "size");
+}
+
+/* Erase every record, checking each against the model, which ends empty. */
+static
+void drain(struct splay_Tree* t, struct Model* m)
+{
+	splay_Satellite sat;
+	splay_Key k;
+
+	while (m -> size > 0) {
+		k = m -> key[0];
+		if (splay_erase(t, k, &sat) != EXIT_SUCCESS
+				|| ! model_remove(m, k, (size_t) sat)) {
+			check(0, "erase while draining");
+			return;
+		}
+	}
+	check(0 == t -> size && NULL == t -> root, "drained tree is empty");
+}
+
+/* Nodes from a slab arena, recycled by erasure and released by clear. */
+static
+void test_slab(unsigned ops, unsigned long* seed)
+{
+	static struct Model m;
+	struct splay_Tree t, u;
+	unsigned i, pass;
+
+	check(EXIT_SUCCESS == splay_tree_slab_ctor(&t, 16), "slab ctor");
+	for (pass = 0; pass < 2; ++pass) {
+		for (i = 0; i < ops; ++i) {
+			churn(&t, &m, seed);
+			check_health(&t, "health of a slab tree");
+		}
+		check(EXIT_SUCCESS == splay_tree_empty_ctor(&u)
+				&& EXIT_SUCCESS == splay_tree_copy(&t, &u)
+				&& u.size == t.size, "copy of a slab tree");
+		check_health(&u, "health of a copy of a slab tree");
+		drain(&u, &m);
+		splay_tree_dtor(&u);
+		check(EXIT_SUCCESS == splay_tree_clear(&t) && 0 == t.size,
+				"clear a slab tree");
+	}
+	splay_tree_dtor(&t);
+}
+
+static
+void* counting_alloc(void* context, size_t size)
+{
+	struct Counting* c = (struct Counting*) context;
+	void* block;
+
+	if (0 == c -> budget)
+		return NULL;
+	c -> budget -= 1;
+	if ((block = malloc(size)) != NULL)
+		c -> live += 1;
+	return block;
+}
+
+static
+void counting_release(void* context, void* block)
+{
+	struct Counting* c = (struct Counting*) context;
+
+	if (block) {
+		c -> live -= 1;
+		free(block);
+	}
+}
+
+/* Set up a counting allocator with an unlimited budget. */
+static
+void counting_ctor(struct splay_Allocator* a, struct Counting* c)
+{
+	c -> live = 0;
+	c -> budget = UINT_MAX;
+	a -> alloc = counting_alloc;
+	a -> release = counting_release;
+	a -> context = c;
+}
+
+/* A custom allocator, with and without an arena, running out of memory. */
+static
+void test_allocator(unsigned ops, unsigned long* seed)
+{
+	static struct Model m;
+	struct splay_Allocator a;
+	struct Counting c;
+	struct splay_Tree t, hi;
+	unsigned chunk, i, n;
+
+	for (chunk = 0; chunk <= 8; chunk += 8) {
+		counting_ctor(&a, &c);
+		check(EXIT_SUCCESS == splay_tree_alloc_ctor(&t, &a, chunk),
+				"alloc ctor");
+		for (i = 0; i < ops; ++i)
+			churn(&t, &m, seed);
+		check(c.live > 0, "nodes come from the allocator");
+
+		/* Insertions use up the free nodes, then fail harmlessly. */
+		c.budget = 0;
+		while (m.size < MAX_RECORDS
+				&& EXIT_SUCCESS == splay_insert(&t, 0, (void*) ++m.serial))
+			model_add(&m, 0, m.serial);
+		check(m.size < MAX_RECORDS && t.size == m.size,
+				"insertion fails without memory");
+		check(splay_count_range(&t, -1, KEYS) == m.size,
+				"count_range without memory");
+		splay_tree_empty_ctor(&hi);
+		n = splay_count_range(&t, -1, KEYS / 2 - 1);
+		check(EXIT_SUCCESS == splay_split(&t, KEYS / 2, &t, &hi)
+				&& t.size == n && hi.size == m.size - n
+				&& EXIT_SUCCESS == splay_join(&t, &hi, &t)
+				&& t.size == m.size, "split without memory");
+		c.budget = UINT_MAX;
+		check_health(&t, "health after running out of memory");
+
+		drain(&t, &m);
+		splay_tree_dtor(&t);
+		splay_tree_dtor(&hi);
+		check(0 == c.live, "all memory returned to the allocator");
+	}
+}
+
+/* Balanced trees built from sorted arrays, with and without satellites. */
+static
+void test_from_sorted(unsigned long* seed)
+{
+	static struct Model m;
+	static splay_Key keys[MAX_RECORDS];
+	static splay_Satellite sats[MAX_RECORDS];
+	const unsigned sizes[] = { 0, 1, 2, 3, 100, MAX_RECORDS };
+	struct splay_Tree t;
+	unsigned i, s;
+
+	for (s = 0; s < sizeof sizes / sizeof sizes[0]; ++s) {
+		for (i = 0; i < sizes[s]; ++i)
+			keys[i] = (splay_Key) (next_random(seed) % KEYS);
+		qsort(keys, sizes[s], sizeof keys[0], key_cmp);
+		for (i = 0; i < sizes[s]; ++i) {
+			sats[i] = (void*) ++m.serial;
+			model_add(&m, keys[i], m.serial);
+		}
+		check(EXIT_SUCCESS == splay_tree_from_sorted(&t, keys, sats, sizes[s])
+				&& t.size == sizes[s], "from_sorted");
+		check_health(&t, "health after from_sorted");
+		drain(&t, &m);
+		splay_tree_dtor(&t);
+	}
+
+	check(EXIT_SUCCESS == splay_tree_from_sorted(&t, keys, NULL, 100)
+			&& splay_find(&t, keys[50]).found
+			&& NULL == splay_find(&t, keys[50]).sat,
+			"from_sorted without satellites");
+	splay_tree_dtor(&t);
+
+	keys[0] = keys[99] + 1;
+	check(EXIT_FAILURE == splay_tree_from_sorted(&t, keys, sats, 100)
+			&& 0 == t.size, "from_sorted rejects unsorted keys");
+	splay_tree_dtor(&t);
+}
+
+static
+void test_range(unsigned ops, unsigned long* seed)
+{
+	static struct Model m;
+	static splay_Key keys[MAX_RECORDS];
+	static splay_Satellite sats[MAX_RECORDS];
+	struct splay_Tree t;
+	splay_Key lo, hi;
+	unsigned i, j, n;
+
+	splay_tree_empty_ctor(&t);
+	for (i = 0; i < ops; ++i) {
+		churn(&t, &m, seed);
+		lo = (splay_Key) (next_random(seed) % KEYS);
+		hi = lo + (splay_Key) (next_random(seed) % 10);
+		n = model_count(&m, lo, hi);
+		check(splay_count_range(&t, lo, hi) == n
+				&& 0 == splay_count_range(&t, hi, lo - 1), "count_range");
+		check(splay_read_range(&t, lo, hi, keys, sats, n) == n
+				&& (0 == n || splay_read_range(&t, lo, hi, keys, NULL, n - 1)
+									== n), "read_range");
+		for (j = 0; j < n; ++j)
+			check(lo <= keys[j] && keys[j] <= hi
+					&& (0 == j || keys[j-1] <= keys[j])
+					&& model_find(&m, keys[j], (size_t) sats[j]) < m.size,
+					"read_range record");
+		check_health(&t, "health after range queries");
+	}
+	drain(&t, &m);
+	splay_tree_dtor(&t);
+}
+
+static
+void test_nearest(unsigned ops, unsigned long* seed)
+{
+	static struct Model m;
+	struct splay_Tree t;
+	splay_Key k;
+	unsigned i;
+
+	splay_tree_empty_ctor(&t);
+	for (i = 0; i < ops; ++i) {
+		churn(&t, &m, seed);
+		k = (splay_Key) (next_random(seed) % (KEYS + 2)) - 1;
+		check(model_nearest(&m, k, 1, 0, splay_find_pred(&t, k)),
+				"find_pred");
+		check(model_nearest(&m, k, 1, 1, splay_find_pred_eq(&t, k)),
+				"find_pred_eq");
+		check(model_nearest(&m, k, 0, 0, splay_find_succ(&t, k)),
+				"find_succ");
+		check(model_nearest(&m, k, 0, 1, splay_find_succ_eq(&t, k)),
+				"find_succ_eq");
+		check(model_nearest(&m, KEYS, 1, 0, splay_max(&t))
+				&& model_nearest(&m, -1, 0, 0, splay_min(&t)), "min, max");
+		check_health(&t, "health after nearest-key queries");
+	}
+	drain(&t, &m);
+	splay_tree_dtor(&t);
+}
+
+/* Walk the tree with a cursor both ways, and seek, comparing to the model. */
+static
+void check_cursor(const struct splay_Tree* t, const struct Model* m,
+					splay_Key k)
+{
+	static splay_Key sorted[MAX_RECORDS];
+	struct splay_Cursor c;
+	struct splay_Result r;
+	unsigned i;
+
+	memcpy(sorted, m -> key, m -> size * sizeof sorted[0]);
+	qsort(sorted, m -> size, sizeof sorted[0], key_cmp);
+	check(EXIT_SUCCESS == splay_cursor_ctor(&c, t), "cursor ctor");
+
+	for (i = 0, r = splay_cursor_first(&c); r.found; r = splay_cursor_next(&c))
+		if (i == m -> size || r.key != sorted[i++]
+				|| model_find(m, r.key, (size_t) r.sat) == m -> size)
+			break;
+	check(! r.found && i == m -> size && ! c.failed, "cursor forward");
+
+	for (r = splay_cursor_last(&c); r.found; r = splay_cursor_prev(&c))
+		if (0 == i || r.key != sorted[--i])
+			break;
+	check(! r.found && 0 == i && ! c.failed, "cursor backward");
+
+	while (i < m -> size && sorted[i] < k)
+		++i;
+	r = splay_cursor_seek(&c, k);
+	check(r.found == (i < m -> size) && (! r.found || r.key == sorted[i]),
+			"cursor seek");
+	splay_cursor_dtor(&c);
+}
+
+static
+void test_cursor(unsigned ops, unsigned long* seed)
+{
+	static struct Model m;
+	struct splay_Tree t;
+	unsigned i;
+
+	splay_tree_empty_ctor(&t);
+	for (i = 0; i < ops; ++i) {
+		check_cursor(&t, &m, (splay_Key) (next_random(seed) % KEYS));
+		churn(&t, &m, seed);
+	}
+	drain(&t, &m);
+	splay_tree_dtor(&t);
+}
+
+/*	A cursor's path comes from its tree's allocator, and the cursor can be
+	destroyed after the tree is moved and destroyed. */
+static
+void test_cursor_alloc(void)
+{
+	struct splay_Allocator a;
+	struct Counting c;
+	struct splay_Tree t, u;
+	struct splay_Cursor cur;
+	unsigned i;
+
+	counting_ctor(&a, &c);
+	splay_tree_alloc_ctor(&t, &a, 0);
+	splay_tree_empty_ctor(&u);
+
+	/* Ascending insertions make a chain, deeper than the initial path. */
+	for (i = 0; i < 1000; ++i)
+		splay_insert(&t, (splay_Key) i, NULL);
+	check(EXIT_SUCCESS == splay_cursor_ctor(&cur, &t)
+			&& splay_cursor_first(&cur).found && ! cur.failed,
+			"cursor on a deep tree");
+
+	splay_tree_move(&t, &u);
+	splay_tree_dtor(&t);
+	splay_tree_dtor(&u);
+	check(c.live > 0, "cursor path comes from the tree's allocator");
+	splay_cursor_dtor(&cur);
+	check(0 == c.live, "cursor returns its path to that allocator");
+}
+
+static
+void test_pop(unsigned ops, unsigned long* seed)
+{
+	static struct Model m;
+	struct splay_Tree t;
+	splay_Satellite sat;
+	splay_Key k;
+	unsigned i, j;
+	int rc;
+
+	splay_tree_empty_ctor(&t);
+	check(EXIT_FAILURE == splay_pop_min(&t, &k, &sat)
+			&& EXIT_FAILURE == splay_pop_max(&t, NULL, NULL),
+			"pop from an empty tree");
+	for (i = 0; i < ops; ++i) {
+		churn(&t, &m, seed);
+		churn(&t, &m, seed);
+		j = next_random(seed) % 2;		/* pop the minimum? */
+		rc = j ? splay_pop_min(&t, &k, &sat) : splay_pop_max(&t, &k, &sat);
+		check(rc == (m.size ? EXIT_SUCCESS : EXIT_FAILURE)
+				&& (! m.size || ((j ? model_count(&m, -1, k - 1)
+									: model_count(&m, k + 1, KEYS)) == 0
+							&& model_remove(&m, k, (size_t) sat))), "pop");
+		check_health(&t, "health after pop");
+	}
+	drain(&t, &m);
+	splay_tree_dtor(&t);
+}
+
+/* Does tree *t hold exactly the records (i, i+1) for i in [0, n)? */
+static
+int is_chain(const struct splay_Tree* t, unsigned n)
+{
+	struct splay_Cursor c;
+	struct splay_Result r;
+	unsigned i = 0;
+
+	splay_cursor_ctor(&c, t);
+	for (r = splay_cursor_first(&c); r.found; r = splay_cursor_next(&c), ++i)
+		if (r.key != (splay_Key) i || (size_t) r.sat != (size_t) i + 1)
+			break;
+	splay_cursor_dtor(&c);
+	return ! r.found && ! c.failed && i == n;
+}
+
+/*	A tree degenerated into a chain, as long as the tree is large, must
+	survive copy, health check and clear; and a copy that runs out of
+	memory must leave the source as it was. */
+static
+void test_deep_chain(void)
+{
+	struct splay_Allocator a;
+	struct Counting c;
+	struct splay_Tree t, u, v;
+	unsigned i;
+
+	counting_ctor(&a, &c);
+	splay_tree_empty_ctor(&t);
+	splay_tree_empty_ctor(&u);
+	splay_tree_alloc_ctor(&v, &a, 0);
+
+	/* Ascending insertions leave each new root with a left child only. */
+	for (i = 0; i < CHAIN; ++i)
+		if (splay_insert(&t, (splay_Key) i, (void*) ((size_t) i + 1)))
+			break;
+	check(CHAIN == t.size, "insert a chain");
+	check_health(&t, "health of a chain");
+
+	check(EXIT_SUCCESS == splay_tree_copy(&t, &u) && CHAIN == u.size,
+			"copy a chain");
+	check_health(&u, "health of a copy of a chain");
+	check(is_chain(&u, CHAIN), "copy of a chain holds its records");
+	check(is_chain(&t, CHAIN), "copy leaves the chain unchanged");
+
+	c.budget = CHAIN / 2;
+	check(EXIT_FAILURE == splay_tree_copy(&t, &v) && 0 == v.size
+			&& NULL == v.root && 0 == c.live,
+			"copy fails cleanly without memory");
+	check(is_chain(&t, CHAIN), "failed copy leaves the chain unchanged");
+	check_health(&t, "health of a chain after a failed copy");
+
+	check(EXIT_SUCCESS == splay_tree_clear(&t) && 0 == t.size
+			&& NULL == t.root, "clear a chain");
+	check(EXIT_SUCCESS == splay_tree_clear(&u) && 0 == u.size, "clear a copy");
+	splay_tree_dtor(&t);
+	splay_tree_dtor(&u);
+	splay_tree_dtor(&v);
+}
+
+/* Non-splaying lookups, which must leave the tree as it is. */
+static
+void test_peek(unsigned ops, unsigned long* seed)
+{
+	static struct Model m;
+	struct splay_Tree t;
+	struct splay_Result r;
+	const struct splay_Node* root;
+	splay_Key k;
+	unsigned i, n;
+
+	splay_tree_empty_ctor(&t);
+	for (i = 0; i < ops; ++i) {
+		churn(&t, &m, seed);
+		k = (splay_Key) (next_random(seed) % KEYS);
+		n = model_count(&m, k, k);
+		root = t.root;
+		r = splay_peek(&t, k);
+		check(r.found == (n > 0) && splay_contains(&t, k) == (n > 0)
+				&& (! r.found || (r.key == k
+						&& model_find(&m, k, (size_t) r.sat) < m.size)),
+				"peek, contains");
+		check(t.root == root, "peek does not splay");
+	}
+	drain(&t, &m);
+	splay_tree_dtor(&t);
+}
+
+/* Forest partitioned by range (with bounds) or by hash, against counts. */
+static
+void test_forest(const splay_Key bounds[], unsigned shards, unsigned ops,
+					unsigned long* seed)
+{
+	static splay_Key keys[MAX_RECORDS];
+	struct splay_Forest f;
+	unsigned count[KEYS], i, j, n, total = 0;
+	splay_Key k;
+	splay_Satellite sat;
+
+	memset(count, 0, sizeof count);
+	check(EXIT_SUCCESS == splay_forest_ctor(&f, shards, bounds), "forest ctor");
+
+	for (i = 0; i < ops; ++i) {
+		n = next_random(seed);
+		k = (splay_Key) (n % KEYS);
+		switch (n / KEYS % 7) {
+			case 0: case 1:
+				check(EXIT_SUCCESS == splay_forest_insert(&f, k,
+										(void*) (size_t) (k + 1)),
+						"forest insert");
+				count[k] += 1;
+				total += 1;
+				break;
+			case 2: case 3:
+				check(splay_forest_erase(&f, k, &sat)
+						== (count[k] ? EXIT_SUCCESS : EXIT_FAILURE)
+						&& (! count[k] || (size_t) sat == (size_t) k + 1),
+						"forest erase");
+				if (count[k]) {
+					count[k] -= 1;
+					total -= 1;
+				}
+				break;
+			case 4:
+				check(splay_forest_update(&f, k, (void*) (size_t) (k + 1))
+						== (count[k] ? EXIT_SUCCESS : EXIT_FAILURE),
+						"forest update");
+				break;
+			case 5:
+				check(splay_forest_find(&f, k).found == (count[k] > 0)
+						&& splay_forest_peek(&f, k).found == (count[k] > 0)
+						&& splay_forest_contains(&f, k) == (count[k] > 0),
+						"forest find, peek");
+				break;
+			default:
+				for (j = n = 0; j < 20 && k + j < KEYS; ++j)
+					n += count[k + j];
+				check(splay_forest_count_range(&f, k, k + 19) == n
+						&& (0 == n || EXIT_FAILURE == splay_forest_read_range(&f,
+											k, k + 19, keys, NULL, n - 1))
+						&& EXIT_SUCCESS == splay_forest_read_range(&f, k, k + 19,
+															keys, NULL, n),
+						"forest count_range, read_range");
+				for (j = 0; j < n; ++j)
+					check(k <= keys[j] && keys[j] < k + 20
+							&& (NULL == bounds || 0 == j || keys[j-1] <= keys[j]),
+							"forest read_range record");
+		}
+		check(splay_forest_size(&f) == total, "forest size");
+	}
+	splay_forest_dtor(&f);
+
+	/* A forest whose construction failed can still be destroyed. */
+	check(EXIT_FAILURE == splay_forest_ctor(&f, 0, NULL), "forest of no shards");
+	splay_forest_dtor(&f);
+}
+
+/* The combiner, from a single thread. */
+static
+void test_combiner(void)
+{
+	struct splay_Tree t;
+	struct splay_Combiner c;
+	struct splay_Slot* s;
+	splay_Satellite sat;
+	unsigned i;
+
+	splay_tree_empty_ctor(&t);
+	check(EXIT_SUCCESS == splay_combiner_ctor(&c, &t, 1), "combiner ctor");
+	check(NULL != (s = splay_combiner_slot(&c)), "combiner slot");
+
+	for (i = 0; i < 100; ++i)
+		check(EXIT_SUCCESS == splay_combined_insert(s, (splay_Key) i, NULL),
+				"combined insert");
+	check(EXIT_SUCCESS == splay_combined_update(s, 7, (void*) &t)
+			&& EXIT_FAILURE == splay_combined_update(s, 100, NULL)
+			&& splay_combined_find(s, 7).sat == (void*) &t
+			&& ! splay_combined_find(s, 100).found, "combined update, find");
+	check(EXIT_SUCCESS == splay_combined_erase(s, 7, &sat) && sat == (void*) &t
+			&& EXIT_FAILURE == splay_combined_erase(s, 7, &sat),
+			"combined erase");
+	check(EXIT_FAILURE == splay_combined_insert(NULL, 0, NULL),
+			"combined insert without a slot");
+
+	splay_combiner_release_slot(s);
+	splay_combiner_dtor(&c);
+	check(99 == t.size, "combined size");
+	check_health(&t, "health after combining");
+	splay_tree_dtor(&t);
+}
+
+static
+void test_find_batch(unsigned ops, unsigned long* seed)
+{
+	static struct Model m;
+	struct splay_Tree t;
+	struct splay_Result results[BATCH];
+	splay_Key keys[BATCH];
+	unsigned i, j;
+
+	splay_tree_empty_ctor(&t);
+	for (i = 0; i < ops; ++i) {
+		churn(&t, &m, seed);
+		for (j = 0; j < BATCH; ++j)
+			keys[j] = (splay_Key) (next_random(seed) % KEYS);
+		if (i % 2)
+			qsort(keys, BATCH, sizeof keys[0], key_cmp);
+		check(EXIT_SUCCESS == splay_find_batch(&t, keys, BATCH, results),
+				"find_batch");
+		for (j = 0; j < BATCH; ++j)
+			check(results[j].found == (model_count(&m, keys[j], keys[j]) > 0)
+					&& (! results[j].found || (results[j].key == keys[j]
+						&& model_find(&m, keys[j], (size_t) results[j].sat)
+							< m.size)), "find_batch result");
+		check_health(&t, "health after find_batch");
+	}
+	drain(&t, &m);
+	splay_tree_dtor(&t);
+}
+
+/* Batches small and large compared to the tree, in random order. */
+static
+void test_insert_batch(unsigned ops, unsigned long* seed)
+{
+	static struct Model m;
+	static splay_Key keys[4 * BATCH];
+	static splay_Satellite sats[4 * BATCH];
+	struct splay_Tree t;
+	unsigned i, j, n;
+
+	splay_tree_empty_ctor(&t);
+	for (i = 0; i < ops; ++i) {
+		churn(&t, &m, seed);
+		churn(&t, &m, seed);
+		n = i % 3 ? 1 + next_random(seed) % BATCH : 4 * BATCH;
+		if (m.size + n > MAX_RECORDS)
+			break;
+		for (j = 0; j < n; ++j) {
+			keys[j] = (splay_Key) (next_random(seed) % KEYS);
+			sats[j] = (void*) ++m.serial;
+			model_add(&m, keys[j], m.serial);
+		}
+		check(EXIT_SUCCESS == splay_insert_batch(&t, keys, sats, n)
+				&& t.size == m.size, "insert_batch");
+		check_health(&t, "health after insert_batch");
+		if (0 == i % 50)
+			drain(&t, &m);
+	}
+	drain(&t, &m);
+	splay_tree_dtor(&t);
+}
+
+/* Split works only with SPLAY_ORDER_STAT; join works either way. */
+static
+void test_split_join(void)
+{
+	struct splay_Tree t, lo, hi;
+	unsigned i;
+
+	splay_tree_empty_ctor(&t);
+	splay_tree_empty_ctor(&lo);
+	splay_tree_empty_ctor(&hi);
+	for (i = 0; i < 100; ++i)
+		splay_insert(&t, (splay_Key) (i * 37 % 100), NULL);
+
+	for (i = 0; i <= 100; i += 25) {
+		check(EXIT_SUCCESS == splay_split(&t, (splay_Key) i, &lo, &hi)
+				&& 0 == t.size && NULL == t.root
+				&& i == lo.size && 100 - i == hi.size
+				&& splay_count_range(&lo, 0, 99) == i
+				&& splay_count_range(&hi, (splay_Key) i, 99) == 100 - i,
+				"split");
+		check_health(&lo, "health after split");
+		check_health(&hi, "health after split");
+		check(EXIT_SUCCESS == splay_join(&lo, &hi, &t) && 100 == t.size,
+				"join after split");
+		check_health(&t, "health after join");
+	}
+	check(EXIT_SUCCESS == splay_split(&t, 30, &t, &hi)
+			&& 30 == t.size && 70 == hi.size && 29 == splay_max(&t).key
+			&& 30 == splay_min(&hi).key, "split into itself");
+	check(EXIT_FAILURE == splay_split(&t, 10, &lo, &hi) && 30 == t.size,
+			"split refuses a nonempty output");
+	check(EXIT_SUCCESS == splay_join(&t, &hi, &t) && 100 == t.size,
+			"join into itself");
+	check_health(&t, "health after split");
+
+	for (i = 100; i < 150; ++i)
+		splay_insert(&hi, (splay_Key) i, NULL);
+	check(EXIT_FAILURE == splay_join(&hi, &t, &lo) && 100 == t.size
+			&& 50 == hi.size, "join refuses overlapping keys");
+	check(EXIT_SUCCESS == splay_join(&t, &hi, &lo) && 150 == lo.size
+			&& 0 == t.size && 0 == hi.size
+			&& 0 == splay_min(&lo).key && 149 == splay_max(&lo).key, "join");
+	check_health(&lo, "health after join");
+
+	splay_tree_dtor(&t);
+	splay_tree_dtor(&lo);
+	splay_tree_dtor(&hi);
+}
+
+/* Remove each erased record from the model, or count an error. */
+static
+void visit_erased(void* context, splay_Key k, splay_Satellite sat)
+{
+	check(model_remove((struct Model*) context, k, (size_t) sat),
+			"erase_range visits a record of the range");
+}
+
+static
+void test_erase_range(unsigned ops, unsigned long* seed)
+{
+	static struct Model m;
+	struct splay_Tree t;
+	splay_Key lo, hi;
+	unsigned i, n;
+
+	splay_tree_empty_ctor(&t);
+	for (i = 0; i < ops; ++i) {
+		churn(&t, &m, seed);
+		churn(&t, &m, seed);
+		lo = (splay_Key) (next_random(seed) % KEYS);
+		hi = lo + (splay_Key) (next_random(seed) % 3);
+		n = model_count(&m, lo, hi);
+		check(0 == splay_erase_range(&t, hi, lo - 1, visit_erased, &m)
+				&& splay_erase_range(&t, lo, hi, visit_erased, &m) == n
+				&& 0 == model_count(&m, lo, hi) && t.size == m.size,
+				"erase_range");
+		check_health(&t, "health after erase_range");
+	}
+	n = m.size;
+	check(splay_erase_range(&t, -1, KEYS, NULL, NULL) == n && 0 == t.size,
+			"erase_range of everything");
+	splay_tree_dtor(&t);
+}
+
+/* Random tree of n records whose satellites are serial numbers, all even
+   or all odd as 'odd' says, and its count of records per key. */
+static
+void random_tree(struct splay_Tree* t, unsigned n, int odd,
+					unsigned long* seed, unsigned count[KEYS])
+{
+	splay_Key keys[KEYS];
+	splay_Satellite sats[KEYS];
+	unsigned i;
+
+	memset(count, 0, KEYS * sizeof count[0]);
+	for (i = 0; i < n && i < KEYS; ++i) {
+		keys[i] = (splay_Key) (next_random(seed) % (KEYS / 2));
+		sats[i] = (void*) (size_t) (2 * i + 2 - odd);
+		count[keys[i]] += 1;
+	}
+	qsort(keys, i, sizeof keys[0], key_cmp);
+	check(EXIT_SUCCESS == splay_tree_from_sorted(t, keys, sats, i),
+			"from_sorted");
+	check_health(t, "health after from_sorted");
+}
+
+static
+void test_set_ops(unsigned long* seed)
+{
+	const enum splay_Policy policies[3] =
+		{ SPLAY_DISTINCT, SPLAY_MULTISET, SPLAY_ALL };
+	struct splay_Tree a, b, out;
+	struct splay_Cursor c;
+	struct splay_Result r;
+	struct splay_Allocator alloc;
+	struct Counting count;
+	unsigned ca[KEYS], cb[KEYS], cout[KEYS], want, i, op, p;
+	int rc;
+
+	random_tree(&a, 60, 1, seed, ca);
+	random_tree(&b, 40, 0, seed, cb);
+
+	for (op = 0; op < 3; ++op)
+		for (p = 0; p < 3; ++p) {
+			splay_tree_empty_ctor(&out);
+			rc = 0 == op ? splay_tree_union(&a, &b, &out, policies[p])
+				: 1 == op ? splay_tree_intersection(&a, &b, &out, policies[p])
+				: splay_tree_difference(&a, &b, &out, policies[p]);
+			check(EXIT_SUCCESS == rc, "set operation");
+			check_health(&out, "health after set operation");
+
+			memset(cout, 0, sizeof cout);
+			splay_cursor_ctor(&c, &out);
+			for (r = splay_cursor_first(&c); r.found; r = splay_cursor_next(&c)) {
+				cout[r.key] += 1;
+				/* A record of *a is preferred, for a single record. */
+				if (SPLAY_DISTINCT == policies[p] && ca[r.key])
+					check((size_t) r.sat % 2, "set operation prefers *a");
+			}
+			splay_cursor_dtor(&c);
+
+			for (i = 0; i < KEYS; ++i) {
+				unsigned na = ca[i], nb = cb[i];
+				if (0 == op)
+					want = SPLAY_DISTINCT == policies[p] ? na + nb > 0
+						: SPLAY_MULTISET == policies[p] ? (na < nb ? nb : na)
+						: na + nb;
+				else if (1 == op)
+					want = ! na || ! nb ? 0
+						: SPLAY_DISTINCT == policies[p] ? 1
+						: SPLAY_MULTISET == policies[p] ? (na < nb ? na : nb)
+						: na + nb;
+				else
+					want = SPLAY_MULTISET == policies[p] ? (na < nb ? 0 : na - nb)
+						: nb ? 0
+						: SPLAY_DISTINCT == policies[p] ? na > 0
+						: na;
+				check(cout[i] == want, "set operation multiplicity");
+			}
+			splay_tree_dtor(&out);
+		}
+
+	/* The result comes from the allocator of *out, or not at all. */
+	counting_ctor(&alloc, &count);
+	splay_tree_alloc_ctor(&out, &alloc, 0);
+	check(EXIT_SUCCESS == splay_tree_union(&a, &b, &out, SPLAY_ALL)
+			&& 100 == out.size && count.live > 0,
+			"set operation uses the allocator of its output");
+	splay_tree_dtor(&out);
+	check(0 == count.live, "set operation result returns its memory");
+	count.budget = 0;
+	splay_tree_alloc_ctor(&out, &alloc, 0);
+	check(EXIT_FAILURE == splay_tree_union(&a, &b, &out, SPLAY_ALL)
+			&& 0 == out.size && NULL == out.root,
+			"set operation fails cleanly without memory");
+	splay_tree_dtor(&out);
+
+	check(60 == a.size && 40 == b.size, "set operations leave inputs alone");
+	splay_tree_dtor(&a);
+	splay_tree_dtor(&b);
+}
+
+static
+void test_upsert(unsigned ops, unsigned long* seed)
+{
+	static struct Model m;
+	struct splay_Tree t;
+	struct splay_Result r;
+	splay_Key k;
+	unsigned i, j, n;
+
+	splay_tree_empty_ctor(&t);
+	for (i = 0; i < ops && m.size < MAX_RECORDS; ++i) {
+		churn(&t, &m, seed);
+		k = (splay_Key) (next_random(seed) % KEYS);
+		n = model_count(&m, k, k);
+		if (i % 2) {
+			check(EXIT_SUCCESS == splay_upsert(&t, k, (void*) ++m.serial, &r)
+					&& r.found == (n > 0), "upsert");
+			if (! r.found)
+				model_add(&m, k, m.serial);
+			else if ((j = model_find(&m, k, (size_t) r.sat)) < m.size)
+				m.sat[j] = m.serial;
+			else
+				check(0, "upsert replaces a record");
+		}
+		else {
+			check(EXIT_SUCCESS == splay_insert_unique(&t, k,
+										(void*) ++m.serial, &r)
+					&& r.found == (n > 0) && t.size == m.size + ! n
+					&& (! n || model_find(&m, k, (size_t) r.sat) < m.size),
+					"insert_unique");
+			if (! n)
+				model_add(&m, k, m.serial);
+		}
+		check(t.size == m.size, "size after upsert");
+		check_health(&t, "health after upsert");
+	}
+	drain(&t, &m);
+	splay_tree_dtor(&t);
+}
+
+/* Erasure down to nothing, from trees of several shapes, in several orders. */
+static
+void test_erase_shapes(unsigned long* seed)
+{
+	static struct Model m;
+	struct splay_Tree t;
+	splay_Satellite sat;
+	splay_Key k;
+	unsigned shape, order, i, j, n = 300;
+
+	for (shape = 0; shape < 3; ++shape)
+		for (order = 0; order < 3; ++order) {
+			/* A left chain, a right chain, or random with duplicates. */
+			splay_tree_empty_ctor(&t);
+			for (i = 0; i < n; ++i) {
+				k = 0 == shape ? (splay_Key) i : 1 == shape ? (splay_Key) (n - i)
+					: (splay_Key) (next_random(seed) % KEYS);
+				splay_insert(&t, k, (void*) ++m.serial);
+				model_add(&m, k, m.serial);
+			}
+
+			/* Erase a random record's key, or the least, or the greatest. */
+			while (m.size > 0) {
+				j = 0 == order ? next_random(seed) % m.size : 0;
+				for (i = 0; order && i < m.size; ++i)
+					if (1 == order ? m.key[i] < m.key[j] : m.key[j] < m.key[i])
+						j = i;
+				k = m.key[j];
+				if (splay_erase(&t, k, &sat) != EXIT_SUCCESS
+						|| ! model_remove(&m, k, (size_t) sat)) {
+					check(0, "erase down to nothing");
+					break;
+				}
+				check_health(&t, "health while erasing down to nothing");
+			}
+			check(0 == t.size && NULL == t.root, "erased down to nothing");
+			m.size = 0;
+			splay_tree_dtor(&t);
+		}
+}
+
+/* Predicate for splay_erase_if():  is the satellite value even? */
+static
+int is_even(void* context, splay_Key k, splay_Satellite sat)
+{
+	(void) context;
+	(void) k;
+	return 0 == (size_t) sat % 2;
+}
+
+static
+void test_erase_exact(unsigned ops, unsigned long* seed)
+{
+	static struct Model m;
+	struct splay_Tree t;
+	splay_Satellite sat;
+	splay_Key k;
+	unsigned i, j, n;
+
+	splay_tree_empty_ctor(&t);
+	for (i = 0; i < ops; ++i) {
+		churn(&t, &m, seed);
+		churn(&t, &m, seed);
+		if (m.size > 0 && i % 2) {
+			j = next_random(seed) % m.size;
+			k = m.key[j];
+			sat = (void*) m.sat[j];
+			check(EXIT_SUCCESS == splay_erase_exact(&t, k, sat)
+					&& EXIT_FAILURE == splay_erase_exact(&t, k, sat)
+					&& model_remove(&m, k, (size_t) sat), "erase_exact");
+		}
+		else {
+			k = (splay_Key) (next_random(seed) % KEYS);
+			for (j = n = 0; j < m.size; ++j)
+				n += m.key[j] == k && 0 == m.sat[j] % 2;
+			check(splay_erase_if(&t, k, is_even, NULL, &sat)
+						== (n ? EXIT_SUCCESS : EXIT_FAILURE)
+					&& (! n || (0 == (size_t) sat % 2
+								&& model_remove(&m, k, (size_t) sat))),
+					"erase_if");
+		}
+		check(t.size == m.size, "size after erase_exact");
+		check_health(&t, "health after erase_exact");
+	}
+	drain(&t, &m);
+	splay_tree_dtor(&t);
+}
+
+/* Bucket trees, against a queue of satellites per key, oldest first. */
+static
+void test_bucket(unsigned ops, unsigned long* seed)
+{
+	static size_t q[BUCKET_KEYS][BUCKET_MAX];
+	unsigned qn[BUCKET_KEYS], i, j, n, keys = 0;
+	struct splay_BucketTree b;
+	struct splay_Result r;
+	const splay_Satellite* all;
+	splay_Satellite sat;
+	size_t serial = 0;
+	splay_Key k;
+
+	memset(qn, 0, sizeof qn);
+	check(EXIT_SUCCESS == splay_bucket_tree_ctor(&b), "bucket ctor");
+	for (i = 0; i < ops; ++i) {
+		n = next_random(seed);
+		k = (splay_Key) (n % BUCKET_KEYS);
+		switch (n / BUCKET_KEYS % 5) {
+			case 0: case 1:
+				if (BUCKET_MAX == qn[k])
+					break;
+				check(EXIT_SUCCESS == splay_bucket_insert(&b, k,
+											(void*) ++serial), "bucket insert");
+				keys += 0 == qn[k];
+				q[k][qn[k]++] = serial;
+				break;
+			case 2:
+				check(splay_bucket_erase(&b, k, &sat)
+						== (qn[k] ? EXIT_SUCCESS : EXIT_FAILURE), "bucket erase");
+				if (0 == qn[k])
+					break;
+				for (j = 0; j < qn[k] && q[k][j] != (size_t) sat; ++j)
+					;
+				check(0 == j, "bucket erase removes the oldest record");
+				for (qn[k] -= 1; j < qn[k]; ++j)
+					q[k][j] = q[k][j + 1];
+				keys -= 0 == qn[k];
+				break;
+			case 3:
+				check(splay_bucket_update(&b, k, (void*) ++serial)
+						== (qn[k] ? EXIT_SUCCESS : EXIT_FAILURE), "bucket update");
+				if (qn[k])
+					q[k][0] = serial;
+				break;
+			default:
+				r = splay_bucket_find(&b, k);
+				check(r.found == (qn[k] > 0) && (! r.found
+						|| (r.key == k && (size_t) r.sat == q[k][0])),
+						"bucket find");
+				all = splay_bucket_find_all(&b, k, &n);
+				check(n == qn[k] && (NULL != all) == (n > 0), "bucket find_all");
+				for (j = 0; j < qn[k]; ++j)
+					check((size_t) all[j] == q[k][j], "bucket find_all record");
+		}
+		for (j = n = 0; j < BUCKET_KEYS; ++j)
+			n += qn[j];
+		check(b.size == n && b.tree.size == keys, "bucket sizes");
+		check_health(& b.tree, "health of bucket tree");
+	}
+
+	/* The nearest keys, each reporting its oldest record. */
+	for (k = 0; k <= BUCKET_KEYS; ++k) {
+		for (j = k + 1; j < BUCKET_KEYS && 0 == qn[j]; ++j)
+			;
+		r = splay_bucket_find_succ(&b, k);
+		check(r.found == (j < BUCKET_KEYS) && (! r.found
+				|| (r.key == (splay_Key) j && (size_t) r.sat == q[j][0])),
+				"bucket find_succ");
+		for (j = k; 0 < j && 0 == qn[j - 1]; --j)
+			;
+		r = splay_bucket_find_pred(&b, k);
+		check(r.found == (0 < j) && (! r.found
+				|| (r.key == (splay_Key) j - 1 && (size_t) r.sat == q[j-1][0])),
+				"bucket find_pred");
+	}
+	r = splay_bucket_min(&b);
+	check(r.found == (keys > 0), "bucket min");
+	r = splay_bucket_max(&b);
+	check(r.found == (keys > 0), "bucket max");
+
+	/* Drain from the top, oldest record first within each key. */
+	for (k = BUCKET_KEYS - 1; k >= 0; --k)
+		for (j = 0; j < qn[k]; ++j)
+			check(EXIT_SUCCESS == splay_bucket_pop_max(&b, &r.key, &sat)
+					&& r.key == k && (size_t) sat == q[k][j],
+					"bucket pop_max");
+	check(0 == b.size && EXIT_FAILURE == splay_bucket_pop_max(&b, NULL, NULL),
+			"bucket pop_max empties the tree");
+	splay_bucket_tree_dtor(&b);
+}
+
+int main(int argc, char** argv)
+{
+	const splay_Key bounds[3] = { 20, 50, 51 };
+	unsigned ops = argc > 1 ? (unsigned) atoi(argv[1]) : 2000;
+	unsigned long seed = 1;
+
+	test_slab(ops, &seed);
+	test_allocator(ops, &seed);
+	test_from_sorted(&seed);
+	test_range(ops, &seed);
+	test_nearest(ops, &seed);
+	test_cursor(ops, &seed);
+	test_cursor_alloc();
+	test_pop(ops, &seed);
+	test_deep_chain();
+	test_peek(ops, &seed);
+	test_forest(bounds, 4, ops, &seed);
+	test_forest(NULL, 3, ops, &seed);
+	test_combiner();
+	test_find_batch(ops, &seed);
+	test_insert_batch(ops, &seed);
+	test_split_join();
+	test_erase_range(ops, &seed);
+	test_set_ops(&seed);
+	test_upsert(ops, &seed);
+	test_erase_shapes(&seed);
+	test_erase_exact(ops, &seed);
+	test_bucket(ops, &seed);
+
+	if (errors)
+		return EXIT_FAILURE;
+	printf("splay API, %u operations per test: ok\n", ops);
+	return EXIT_SUCCESS;
+}
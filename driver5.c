@@ -0,0 +1,404 @@
+/**
+ * @file
+ * @author Andrew Predoehl
+ * @brief Test of the augmented build, against a brute-force model
+ *
+ * This and the library must be compiled with SPLAY_ORDER_STAT,
+ * SPLAY_AGGREGATE and SPLAY_INTERVAL all nonzero (see the Makefile).
+ * Random operations, drawn from the table below, are applied to a tree, and
+ * every answer is checked against a plain array of the records.  The tree
+ * must pass splay_health_check() after every operation, which verifies the
+ * subtree counts and any other augmented fields too.
+ *
+ * Usage:  driver5 [operations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "splay.h"
+
+#if ! SPLAY_AGGREGATE
+#error "driver5 must be compiled with -DSPLAY_AGGREGATE=1"
+#endif
+
+#define KEYS 200			/* keys are drawn from [0, KEYS) */
+#define SPAN 20				/* longest interval, minus one */
+#define MAX_RECORDS 4096
+
+/*	The model:  the records in no particular order.  Every satellite value
+	is a distinct serial number, so a record can be identified by it. */
+struct Model {
+	splay_Key key[MAX_RECORDS];
+	splay_Key hi[MAX_RECORDS];	/* right endpoint of each interval */
+	size_t sat[MAX_RECORDS];
+	unsigned size;
+	size_t serial;				/* last satellite value issued */
+	int lost;					/* boolean: a removal matched no record */
+};
+
+/* Totals of the records reported by splay_interval_overlap(). */
+struct Overlap {
+	splay_Key lo, hi, prev;		/* query, and key of the last report */
+	unsigned count;
+	long sum;
+	int bad;					/* boolean: a report was wrong */
+};
+
+/*	An operation applies a random change or query to the tree and the
+	model, with k drawn from [0, KEYS); it returns the number of errors. */
+typedef unsigned (*Operation)(struct splay_Tree* t, struct Model* m,
+								splay_Key k, unsigned long* seed);
+
+static
+int fail(const char* msg)
+{
+	fprintf(stderr, "Error: %s\n", msg);
+	return EXIT_FAILURE;
+}
+
+/* Small linear congruential generator, so runs are repeatable. */
+static
+unsigned next_random(unsigned long* seed)
+{
+	*seed = (*seed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+	return (unsigned) (*seed >> 8);
+}
+
+static
+void model_add(struct Model* m, splay_Key k, size_t sat)
+{
+	m -> key[m -> size] = k;
+	m -> hi[m -> size] = k;
+	m -> sat[m -> size] = sat;
+	m -> size += 1;
+}
+
+/* Remove the record with satellite sat, and key k; false if there is none. */
+static
+int model_remove(struct Model* m, splay_Key k, size_t sat)
+{
+	unsigned i;
+
+	for (i = 0; i < m -> size; ++i)
+		if (m -> sat[i] == sat) {
+			if (m -> key[i] != k)
+				return 0;
+			m -> size -= 1;
+			m -> key[i] = m -> key[m -> size];
+			m -> hi[i] = m -> hi[m -> size];
+			m -> sat[i] = m -> sat[m -> size];
+			return 1;
+		}
+	return 0;
+}
+
+/* Number of records with keys in [lo, hi], and the sum of their satellites. */
+static
+unsigned model_count(const struct Model* m, splay_Key lo, splay_Key hi,
+						long* sum)
+{
+	unsigned i, n = 0;
+
+	if (sum)
+		*sum = 0;
+	for (i = 0; i < m -> size; ++i)
+		if (lo <= m -> key[i] && m -> key[i] <= hi) {
+			n += 1;
+			if (sum)
+				*sum += (long) m -> sat[i];
+		}
+	return n;
+}
+
+/* Random closed interval, possibly reaching a little past the keys. */
+static
+void random_range(unsigned long* seed, splay_Key* lo, splay_Key* hi)
+{
+	splay_Key swap;
+
+	*lo = (splay_Key) (next_random(seed) % (KEYS + 20));
+	*hi = (splay_Key) (next_random(seed) % (KEYS + 20));
+	if (*hi < *lo) {
+		swap = *lo;
+		*lo = *hi;
+		*hi = swap;
+	}
+}
+
+static
+unsigned op_insert(struct splay_Tree* t, struct Model* m, splay_Key k,
+					unsigned long* seed)
+{
+	(void) seed;
+	if (m -> size == MAX_RECORDS)
+		return 0;
+	if (splay_insert(t, k, (void*) ++m -> serial))
+		return 1;
+	model_add(m, k, m -> serial);
+	return 0;
+}
+
+static
+unsigned op_erase(struct splay_Tree* t, struct Model* m, splay_Key k,
+					unsigned long* seed)
+{
+	splay_Satellite sat;
+	unsigned n = model_count(m, k, k, NULL);
+
+	(void) seed;
+	if (splay_erase(t, k, &sat) != (n ? EXIT_SUCCESS : EXIT_FAILURE))
+		return 1;
+	return n && ! model_remove(m, k, (size_t) sat);
+}
+
+/* The rank of k, and the key of that rank, if there is one. */
+static
+unsigned op_rank_select(struct splay_Tree* t, struct Model* m, splay_Key k,
+						unsigned long* seed)
+{
+	struct splay_Result r;
+	unsigned n = model_count(m, -1, k - 1, NULL), i;
+
+	(void) seed;
+	if (splay_rank(t, k, &i) || i != n)
+		return 1;
+	r = splay_select(t, n);
+	return r.found != (n < m -> size)
+		|| (r.found && (r.key < k
+				|| model_count(m, -1, r.key - 1, NULL) > n
+				|| model_count(m, -1, r.key, NULL) <= n));
+}
+
+static
+unsigned op_pop_min(struct splay_Tree* t, struct Model* m, splay_Key k,
+					unsigned long* seed)
+{
+	splay_Satellite sat;
+
+	(void) seed;
+	return splay_pop_min(t, &k, &sat) != (m -> size ? EXIT_SUCCESS : EXIT_FAILURE)
+		|| (m -> size && (model_count(m, -1, k - 1, NULL)
+						|| ! model_remove(m, k, (size_t) sat)));
+}
+
+/* Split at k, check both parts, and join them back. */
+static
+unsigned op_split_join(struct splay_Tree* t, struct Model* m, splay_Key k,
+						unsigned long* seed)
+{
+	struct splay_Tree lo, hi;
+	unsigned n = model_count(m, -1, k - 1, NULL), errors;
+
+	(void) seed;
+	errors = splay_tree_empty_ctor(&lo) || splay_tree_empty_ctor(&hi)
+		|| splay_split(t, k, &lo, &hi)
+		|| lo.size != n || hi.size != m -> size - n || 0 != t -> size
+		|| splay_health_check(&lo, NULL, 0) || splay_health_check(&hi, NULL, 0)
+		|| (lo.size && ! (splay_max(&lo).key < k))
+		|| (hi.size && splay_min(&hi).key < k)
+		|| splay_range_aggregate(&lo, k, KEYS + 20) != 0
+		|| splay_range_aggregate(&hi, -1, k - 1) != 0
+		|| splay_join(&lo, &hi, t) || t -> size != m -> size;
+	splay_tree_dtor(&lo);
+	splay_tree_dtor(&hi);
+	return errors;
+}
+
+/* Remove each erased record from the model, or note that it was absent. */
+static
+void visit_erased(void* context, splay_Key k, splay_Satellite sat)
+{
+	struct Model* m = (struct Model*) context;
+
+	if (! model_remove(m, k, (size_t) sat))
+		m -> lost = 1;
+}
+
+/* Erase a narrow range, so the tree does not empty too fast. */
+static
+unsigned op_erase_range(struct splay_Tree* t, struct Model* m, splay_Key k,
+						unsigned long* seed)
+{
+	splay_Key hi = k + (splay_Key) (next_random(seed) % 3);
+	unsigned n = model_count(m, k, hi, NULL);
+
+	return splay_erase_range(t, k, hi, visit_erased, m) != n || m -> lost;
+}
+
+/* Replace the satellite of a record with key k, or add one. */
+static
+unsigned op_upsert(struct splay_Tree* t, struct Model* m, splay_Key k,
+					unsigned long* seed)
+{
+	struct splay_Result r;
+	unsigned i;
+
+	(void) seed;
+	if (m -> size == MAX_RECORDS)
+		return 0;
+	if (splay_upsert(t, k, (void*) ++m -> serial, &r))
+		return 1;
+	if (! r.found) {
+		model_add(m, k, m -> serial);
+		return 0;
+	}
+	for (i = 0; i < m -> size; ++i)
+		if ((void*) m -> sat[i] == r.sat && m -> key[i] == k) {
+			m -> sat[i] = m -> serial;
+			return 0;
+		}
+	return 1;
+}
+
+/* Erase a random record of the model by its key and satellite. */
+static
+unsigned op_erase_exact(struct splay_Tree* t, struct Model* m, splay_Key k,
+						unsigned long* seed)
+{
+	unsigned i;
+
+	if (0 == m -> size)
+		return 0;
+	i = next_random(seed) % m -> size;
+	k = m -> key[i];
+	return splay_erase_exact(t, k, (void*) m -> sat[i])
+		|| ! model_remove(m, k, m -> sat[i]);
+}
+
+/* Read a range, first into buffers half as long as it needs, then whole. */
+static
+unsigned op_read_range(struct splay_Tree* t, struct Model* m, splay_Key k,
+						unsigned long* seed)
+{
+	static splay_Key keys[MAX_RECORDS];
+	splay_Key lo, hi;
+	unsigned i, n, half;
+
+	(void) k;
+	random_range(seed, &lo, &hi);
+	n = model_count(m, lo, hi, NULL);
+	half = n / 2;
+	if (splay_read_range(t, lo, hi, keys, NULL, half) != n
+			|| splay_read_range(t, lo, hi, keys, NULL, n) != n)
+		return 1;
+	for (i = 0; i < n; ++i)
+		if (keys[i] < lo || hi < keys[i] || (i && keys[i] < keys[i - 1])
+				|| ! model_count(m, keys[i], keys[i], NULL))
+			return 1;
+	return 0;
+}
+
+static
+unsigned op_aggregate(struct splay_Tree* t, struct Model* m, splay_Key k,
+						unsigned long* seed)
+{
+	splay_Key lo, hi;
+	long sum;
+
+	(void) k;
+	random_range(seed, &lo, &hi);
+	return model_count(m, lo, hi, &sum) != splay_count_range(t, lo, hi)
+		|| splay_range_aggregate(t, lo, hi) != sum
+		|| splay_range_aggregate(t, hi + 1, lo) != 0;
+}
+
+/* Insert an interval starting at k, and check that a reversed one fails. */
+static
+unsigned op_interval_insert(struct splay_Tree* t, struct Model* m, splay_Key k,
+							unsigned long* seed)
+{
+	splay_Key hi = k + (splay_Key) (next_random(seed) % (SPAN + 1));
+
+	if (m -> size == MAX_RECORDS)
+		return 0;
+	if (splay_interval_insert(t, k, hi, (void*) ++m -> serial))
+		return 1;
+	model_add(m, k, m -> serial);
+	m -> hi[m -> size - 1] = hi;
+	return EXIT_SUCCESS == splay_interval_insert(t, k, k - 1, NULL);
+}
+
+static
+void visit_overlap(void* context, splay_Key lo, splay_Key hi,
+					splay_Satellite sat)
+{
+	struct Overlap* o = (struct Overlap*) context;
+
+	if (hi < lo || hi < o -> lo || o -> hi < lo || lo < o -> prev)
+		o -> bad = 1;
+	o -> prev = lo;
+	o -> count += 1;
+	o -> sum += (long) (size_t) sat;
+}
+
+/* The records reported must be exactly those whose intervals overlap. */
+static
+unsigned op_overlap(struct splay_Tree* t, struct Model* m, splay_Key k,
+					unsigned long* seed)
+{
+	struct Overlap o;
+	unsigned i;
+
+	(void) k;
+	random_range(seed, &o.lo, &o.hi);
+	o.prev = -1;
+	o.count = 0;
+	o.sum = 0;
+	o.bad = 0;
+	if (splay_interval_overlap(t, o.lo, o.hi, visit_overlap, &o) || o.bad)
+		return 1;
+	for (i = 0; i < m -> size; ++i)
+		if (m -> key[i] <= o.hi && o.lo <= m -> hi[i]) {
+			o.count -= 1;
+			o.sum -= (long) m -> sat[i];
+		}
+	return o.count || o.sum;
+}
+
+/* Operations, repeated to weight their frequency. */
+static const Operation ops_table[] = {
+	op_insert, op_insert, op_insert, op_erase, op_rank_select,
+	op_pop_min,
+	op_split_join,
+	op_erase_range,
+	op_upsert,
+	op_erase_exact,
+	op_read_range, op_aggregate,
+	op_interval_insert, op_interval_insert, op_overlap,
+};
+
+#define NOPS (sizeof ops_table / sizeof ops_table[0])
+
+int main(int argc, char** argv)
+{
+	static struct Model m;
+	struct splay_Tree t;
+	unsigned i, n, ops = argc > 1 ? (unsigned) atoi(argv[1]) : 20000,
+		errors = 0;
+	unsigned long seed = 1;
+	char buf[256];
+
+	if (splay_tree_empty_ctor(&t))
+		return fail("cannot construct tree");
+
+	for (i = 0; i < ops && 0 == errors; ++i) {
+		n = next_random(&seed);
+		errors += ops_table[n / KEYS % NOPS](&t, &m, (splay_Key) (n % KEYS),
+												&seed);
+		if (t.size != m.size)
+			errors += 1;
+		if (splay_health_check(&t, buf, sizeof buf)) {
+			fprintf(stderr, "%s\n", buf);
+			errors += 1;
+		}
+	}
+	splay_tree_dtor(&t);
+
+	if (errors) {
+		fprintf(stderr, "Operation %u failed\n", i);
+		return fail("augmented tree disagrees with the model");
+	}
+	printf("augmented splay, %u operations: ok\n", ops);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+/**
+ * @file
+ * @author Andrew Predoehl
+ * @brief Test of trees generated by splay_define.h for non-int keys
+ *
+ * Three instantiations are exercised:  unsigned long timestamps, double
+ * keys, and fixed-length byte strings wrapped in a struct and compared with
+ * memcmp.  Each gets random insertions, finds, updates, erasures,
+ * predecessor and successor queries and range reads, checked against a
+ * simple count of records per key, then is emptied through its pop
+ * functions, which must deliver the keys in order.
+ *
+ * Usage:  driver6 [operations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "splay_define.h"
+
+#define KEYS 97
+#define RANGE_BUF 16
+
+struct Bytes {
+	unsigned char b[12];
+};
+
+#define NUM_LESS(a, b) ((a) < (b))
+#define BYTES_LESS(a, b) (bytes_cmp(&(a), &(b)) < 0)
+
+static
+int bytes_cmp(const struct Bytes* a, const struct Bytes* b)
+{
+	return memcmp(a -> b, b -> b, sizeof a -> b);
+}
+
+SPLAY_DECLARE(ts, unsigned long)
+SPLAY_DEFINE(ts, unsigned long, NUM_LESS)
+
+SPLAY_DECLARE(dbl, double)
+SPLAY_DEFINE(dbl, double, NUM_LESS)
+
+SPLAY_DECLARE(byt, struct Bytes)
+SPLAY_DEFINE(byt, struct Bytes, BYTES_LESS)
+
+
+static
+int fail(const char* msg)
+{
+	fprintf(stderr, "Error: %s\n", msg);
+	return EXIT_FAILURE;
+}
+
+/* Small linear congruential generator, so runs are repeatable. */
+static
+unsigned next_random(unsigned long* seed)
+{
+	*seed = (*seed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+	return (unsigned) (*seed >> 8);
+}
+
+/* Key number j (less than KEYS) in each key type, increasing with j.
+   The timestamps are large, and the byte strings differ only at the end. */
+static unsigned long ts_key(unsigned j) { return 1500000000UL + 1000UL * j; }
+static double dbl_key(unsigned j) { return -1.5 + j / 8.0; }
+
+static
+struct Bytes byt_key(unsigned j)
+{
+	struct Bytes k;
+	memset(k.b, 'x', sizeof k.b);
+	k.b[sizeof k.b - 2] = (unsigned char) (j / 16);
+	k.b[sizeof k.b - 1] = (unsigned char) (j % 16);
+	return k;
+}
+
+/* Is k key number j? */
+static int ts_same(unsigned long k, unsigned j) { return k == ts_key(j); }
+static int dbl_same(double k, unsigned j) { return k == dbl_key(j); }
+
+static
+int byt_same(struct Bytes k, unsigned j)
+{
+	struct Bytes kj = byt_key(j);
+	return 0 == bytes_cmp(&k, &kj);
+}
+
+/* Count an error unless r found key number m, or nothing if m is KEYS. */
+#define EXPECT(name, r, m, errors) \
+	if ((r).found != ((m) < KEYS) \
+			|| ((r).found && (! name##_same((r).key, (m)) \
+								|| (size_t) (r).sat != (m) + 1))) \
+		(errors) += 1
+
+/*	Run the random test on an instantiation.  The same sequence of
+	operations is used for every key type, so the same model applies. */
+#define RUN_TEST(name, KeyT, ops, errors) \
+do { \
+	struct name##_Tree t; \
+	struct name##_Result r; \
+	unsigned count[KEYS], i, j, m, n, hi, want, seen, total = 0; \
+	unsigned long seed = 1; \
+	void* sat; \
+	KeyT keys[RANGE_BUF]; \
+	void* sats[RANGE_BUF]; \
+ \
+	memset(count, 0, sizeof count); \
+	name##_tree_empty_ctor(&t); \
+	for (i = 0; i < (ops); ++i) { \
+		n = next_random(&seed); \
+		j = n % KEYS; \
+		switch (n / KEYS % 7) { \
+			case 0: case 1: \
+				if (name##_insert(&t, name##_key(j), (void*) (size_t) (j + 1))) \
+					(errors) += 1; \
+				count[j] += 1; \
+				total += 1; \
+				break; \
+			case 2: \
+				r = name##_find(&t, name##_key(j)); \
+				if (r.found != (count[j] > 0) \
+						|| (r.found && (! name##_same(r.key, j) \
+									|| (size_t) r.sat != j + 1))) \
+					(errors) += 1; \
+				break; \
+			case 3: \
+				if (name##_update(&t, name##_key(j), (void*) (size_t) (j + 1)) \
+						!= (count[j] ? EXIT_SUCCESS : EXIT_FAILURE)) \
+					(errors) += 1; \
+				break; \
+			case 5: \
+				for (m = j; m > 0 && 0 == count[m - 1]; --m) \
+					; \
+				m = m > 0 ? m - 1 : KEYS; \
+				r = name##_find_pred(&t, name##_key(j)); \
+				EXPECT(name, r, m, errors); \
+				r = name##_find_pred_eq(&t, name##_key(j)); \
+				EXPECT(name, r, count[j] ? j : m, errors); \
+				for (m = j + 1; m < KEYS && 0 == count[m]; ++m) \
+					; \
+				r = name##_find_succ(&t, name##_key(j)); \
+				EXPECT(name, r, m, errors); \
+				r = name##_find_succ_eq(&t, name##_key(j)); \
+				EXPECT(name, r, count[j] ? j : m, errors); \
+				break; \
+			case 6: \
+				hi = j + n / KEYS / 7 % 8; \
+				if (hi >= KEYS) \
+					hi = KEYS - 1; \
+				for (want = 0, m = j; m <= hi; ++m) \
+					want += count[m]; \
+				if (name##_count_range(&t, name##_key(j), name##_key(hi)) \
+						!= want \
+						|| (j < hi && name##_count_range(&t, name##_key(hi), \
+														name##_key(j)))) \
+					(errors) += 1; \
+				if (name##_read_range(&t, name##_key(j), name##_key(hi), \
+									keys, sats, RANGE_BUF) != want) \
+					(errors) += 1; \
+				for (m = j, seen = 0, n = 0; n < want && n < RANGE_BUF; ++n) { \
+					while (seen == count[m]) { \
+						++m; \
+						seen = 0; \
+					} \
+					if (! name##_same(keys[n], m) \
+							|| (size_t) sats[n] != m + 1) \
+						(errors) += 1; \
+					++seen; \
+				} \
+				break; \
+			default: \
+				if (name##_erase(&t, name##_key(j), &sat) \
+						!= (count[j] ? EXIT_SUCCESS : EXIT_FAILURE)) \
+					(errors) += 1; \
+				else if (count[j]) { \
+					count[j] -= 1; \
+					total -= 1; \
+					if ((size_t) sat != j + 1) \
+						(errors) += 1; \
+				} \
+		} \
+		if (t.size != total) \
+			(errors) += 1; \
+	} \
+ \
+	/* Drain from both ends; the keys must come out in order. */ \
+	for (i = 0, j = KEYS - 1; t.size > 0; ) { \
+		while (0 == count[i]) \
+			++i; \
+		r = name##_min(&t); \
+		if (! r.found || ! name##_same(r.key, i) \
+				|| name##_pop_min(&t, NULL, NULL)) \
+			(errors) += 1; \
+		count[i] -= 1; \
+		if (0 == t.size) \
+			break; \
+		while (0 == count[j]) \
+			--j; \
+		r = name##_max(&t); \
+		if (! r.found || ! name##_same(r.key, j) \
+				|| name##_pop_max(&t, NULL, NULL)) \
+			(errors) += 1; \
+		count[j] -= 1; \
+	} \
+	r = name##_find(&t, name##_key(0)); \
+	if (r.found || r.sat != NULL) \
+		(errors) += 1; \
+	name##_tree_dtor(&t); \
+} while (0)
+
+int main(int argc, char** argv)
+{
+	unsigned ops = argc > 1 ? (unsigned) atoi(argv[1]) : 100000,
+		errors = 0;
+
+	RUN_TEST(ts, unsigned long, ops, errors);
+	RUN_TEST(dbl, double, ops, errors);
+	RUN_TEST(byt, struct Bytes, ops, errors);
+
+	if (errors)
+		return fail("generated trees disagree with the model");
+	printf("splay_define.h, %u operations per key type: ok\n", ops);
+	return EXIT_SUCCESS;
+}
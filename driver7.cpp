@@ -0,0 +1,215 @@
+/**
+ * @file
+ * @author Andrew Predoehl
+ * @brief Test of the header-only C++ splay_tree template
+ *
+ * Random insertions, lookups and erasures are applied both to a splay_tree
+ * and to a std::map, which must agree throughout.  Then the special cases:
+ * move-only values, comparators that cannot be base classes (a function
+ * pointer and a final class), and a stateful allocator that does not
+ * propagate, for copying, moving and swapping.
+ *
+ * Usage:  driver7 [operations]
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "splay_tree.hpp"
+
+namespace {
+
+using predoehl::splay_tree;
+
+int errors = 0;
+
+void check(bool ok, const char* what)
+{
+	if (! ok) {
+		std::cerr << "Error: " << what << '\n';
+		errors += 1;
+	}
+}
+
+/* Small linear congruential generator, so runs are repeatable. */
+unsigned next_random(unsigned long* seed)
+{
+	*seed = (*seed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+	return static_cast<unsigned>(*seed >> 8);
+}
+
+template <typename T, typename M>
+bool same(const T& t, const M& m)
+{
+	return t.size() == m.size() && std::equal(t.begin(), t.end(), m.begin());
+}
+
+void test_against_map(unsigned ops)
+{
+	splay_tree<int, std::string> t;
+	std::map<int, std::string> m;
+	unsigned long seed = 1;
+
+	for (unsigned i = 0; i < ops; ++i) {
+		unsigned r = next_random(&seed);
+		int k = static_cast<int>(r % 500);
+		std::string v = std::to_string(r);
+
+		switch (r / 500 % 6) {
+			case 0:
+				check(t.insert(std::make_pair(k, v)).second
+						== m.insert(std::make_pair(k, v)).second, "insert");
+				break;
+			case 1:
+				t[k] = v;
+				m[k] = v;
+				break;
+			case 2:
+				check(t.erase(k) == m.erase(k), "erase by key");
+				break;
+			case 3: {
+				splay_tree<int, std::string>::iterator i = t.find(k);
+				std::map<int, std::string>::iterator j = m.find(k);
+				check((i == t.end()) == (j == m.end())
+						&& (i == t.end() || i -> second == j -> second),
+						"find");
+				break;
+			}
+			case 4: {
+				splay_tree<int, std::string>::iterator i = t.lower_bound(k);
+				std::map<int, std::string>::iterator j = m.lower_bound(k);
+				check((i == t.end()) == (j == m.end())
+						&& (i == t.end() || i -> first == j -> first),
+						"lower_bound");
+				if (i != t.end()) {
+					t.erase(i);
+					m.erase(j);
+				}
+				break;
+			}
+			default: {
+				const splay_tree<int, std::string>& ct = t;
+				splay_tree<int, std::string>::const_iterator i =
+														ct.upper_bound(k);
+				std::map<int, std::string>::iterator j = m.upper_bound(k);
+				check((i == ct.end()) == (j == m.end())
+						&& (i == ct.end() || i -> first == j -> first),
+						"upper_bound");
+			}
+		}
+	}
+	check(same(t, m), "contents after random operations");
+	check(std::equal(t.rbegin(), t.rend(), m.rbegin()), "reverse iteration");
+
+	splay_tree<int, std::string> u(t);
+	check(same(u, m), "copy");
+	splay_tree<int, std::string> w(std::move(u));
+	check(same(w, m) && u.empty(), "move construction");
+	u = w;
+	check(same(u, m), "copy assignment");
+	w.clear();
+	w = std::move(u);
+	check(same(w, m) && u.empty(), "move assignment");
+}
+
+void test_move_only()
+{
+	splay_tree<int, std::unique_ptr<int> > t;
+
+	for (int i = 0; i < 100; ++i)
+		t.try_emplace(i * 7 % 100, new int(i));
+	check(100 == t.size() && 3 == *t.at(21), "move-only values");
+
+	splay_tree<int, std::unique_ptr<int> > u(std::move(t));
+	u.erase(u.begin(), u.find(50));
+	check(50 == u.size() && 50 == u.begin() -> first, "erase a range");
+}
+
+bool greater(int a, int b) { return a > b; }
+
+struct Final final {
+	bool operator()(int a, int b) const { return a < b; }
+};
+
+void test_comparators()
+{
+	splay_tree<int, int, bool (*)(int, int)> f(greater);
+	splay_tree<int, int, Final> g;
+
+	for (int i = 0; i < 50; ++i) {
+		f[i] = i;
+		g[i] = i;
+	}
+	check(49 == f.begin() -> first && 0 == g.begin() -> first,
+			"function pointer and final comparators");
+	check(sizeof(splay_tree<int, int>) < sizeof(f), "empty comparator");
+}
+
+/* Allocator with an identity, which does not follow the containers. */
+template <typename T>
+struct Tagged {
+	typedef T value_type;
+	typedef std::false_type propagate_on_container_move_assignment;
+	typedef std::false_type is_always_equal;
+	int tag;
+
+	explicit Tagged(int t) : tag(t) {}
+	template <typename U> Tagged(const Tagged<U>& a) : tag(a.tag) {}
+	T* allocate(std::size_t n)
+	{
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+	void deallocate(T* p, std::size_t) { ::operator delete(p); }
+};
+
+template <typename T, typename U>
+bool operator==(const Tagged<T>& a, const Tagged<U>& b)
+{
+	return a.tag == b.tag;
+}
+
+template <typename T, typename U>
+bool operator!=(const Tagged<T>& a, const Tagged<U>& b)
+{
+	return a.tag != b.tag;
+}
+
+void test_allocators()
+{
+	typedef splay_tree<int, int, std::less<int>,
+						Tagged<std::pair<const int, int> > > tree;
+	tree a((Tagged<int>(1))), b((Tagged<int>(2)));
+
+	for (int i = 0; i < 100; ++i)
+		a[i] = -i;
+	b = std::move(a);
+	check(100 == b.size() && 2 == b.get_allocator().tag && -99 == b.at(99),
+			"move assignment between unequal allocators");
+
+	static_assert(std::is_nothrow_move_assignable<splay_tree<int, int> >::value,
+					"moving with std::allocator must not throw");
+	static_assert(! std::is_nothrow_move_assignable<tree>::value,
+					"moving between unequal allocators may throw");
+}
+
+} // end anonymous namespace
+
+int main(int argc, char** argv)
+{
+	unsigned ops = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+	test_against_map(ops);
+	test_move_only();
+	test_comparators();
+	test_allocators();
+
+	if (errors)
+		return EXIT_FAILURE;
+	std::cout << "splay_tree, " << ops << " operations: ok\n";
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file
+ * @author Andrew Predoehl
+ * @brief Stress test of the flat-combining front end, with many threads
+ *
+ * Each thread inserts, erases and finds keys in a range of its own, through
+ * the combiner, and checks every answer against its own count of records.
+ * All threads also insert into one shared range, to keep the combiner lock
+ * contended.  At the end the tree is checked against the sum of the counts.
+ *
+ * Usage:  driver8 [threads [operations per thread]]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "splay_combine.h"
+
+#define MAX_THREADS 32
+#define KEYS 256			/* size of each thread's key range */
+#define SHARED 1000000		/* first key of the shared range */
+
+struct Worker {
+	struct splay_Combiner* combiner;
+	unsigned ops;
+	unsigned long seed;
+	unsigned base;				/* first key of this thread's range */
+	unsigned count[KEYS];		/* records per key in this thread's range */
+	unsigned shared;			/* inserts into the shared range */
+	unsigned errors;
+};
+
+static
+int fail(const char* msg)
+{
+	fprintf(stderr, "Error: %s\n", msg);
+	return EXIT_FAILURE;
+}
+
+/* Small linear congruential generator, private to each thread. */
+static
+unsigned next_random(unsigned long* seed)
+{
+	*seed = (*seed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+	return (unsigned) (*seed >> 8);
+}
+
+static
+void* work(void* arg)
+{
+	struct Worker* w = (struct Worker*) arg;
+	struct splay_Slot* s = splay_combiner_slot(w -> combiner);
+	unsigned i, j, r;
+	splay_Satellite sat;
+
+	if (NULL == s) {
+		w -> errors += 1;
+		return NULL;
+	}
+
+	for (i = 0; i < w -> ops; ++i) {
+		r = next_random(& w -> seed);
+		j = r % KEYS;
+		switch (r / KEYS % 8) {
+			case 0: case 1: case 2:
+				if (splay_combined_insert(s, w -> base + j, NULL))
+					w -> errors += 1;
+				else
+					w -> count[j] += 1;
+				break;
+			case 3: case 4:
+				if (splay_combined_erase(s, w -> base + j, &sat)
+						!= (w -> count[j] ? EXIT_SUCCESS : EXIT_FAILURE))
+					w -> errors += 1;
+				else if (w -> count[j])
+					w -> count[j] -= 1;
+				break;
+			case 5: case 6:
+				if (splay_combined_find(s, w -> base + j).found
+						!= (w -> count[j] > 0))
+					w -> errors += 1;
+				break;
+			default:
+				if (splay_combined_insert(s, SHARED + j, NULL))
+					w -> errors += 1;
+				else
+					w -> shared += 1;
+		}
+	}
+
+	splay_combiner_release_slot(s);
+	return NULL;
+}
+
+int main(int argc, char** argv)
+{
+	static struct Worker w[MAX_THREADS];
+	pthread_t id[MAX_THREADS];
+	struct splay_Tree t;
+	struct splay_Combiner c;
+	unsigned i, j, nthreads = 8, ops = 100000, total = 0, shared = 0,
+		errors = 0;
+	char buf[256];
+
+	if (argc > 1)
+		nthreads = (unsigned) atoi(argv[1]);
+	if (argc > 2)
+		ops = (unsigned) atoi(argv[2]);
+	if (nthreads < 1 || nthreads > MAX_THREADS)
+		return fail("thread count out of range");
+
+	if (splay_tree_empty_ctor(&t) || splay_combiner_ctor(&c, &t, nthreads))
+		return fail("cannot construct tree or combiner");
+
+	for (i = 0; i < nthreads; ++i) {
+		w[i].combiner = &c;
+		w[i].ops = ops;
+		w[i].seed = 1 + i;
+		w[i].base = i * KEYS;
+		if (pthread_create(id + i, NULL, work, w + i))
+			return fail("cannot create thread");
+	}
+	for (i = 0; i < nthreads; ++i)
+		pthread_join(id[i], NULL);
+	splay_combiner_dtor(&c);
+
+	for (i = 0; i < nthreads; ++i) {
+		errors += w[i].errors;
+		shared += w[i].shared;
+		for (j = 0; j < KEYS; ++j) {
+			total += w[i].count[j];
+			if (splay_count_range(&t, w[i].base + j, w[i].base + j)
+					!= w[i].count[j])
+				errors += 1;
+		}
+	}
+	if (splay_count_range(&t, SHARED, SHARED + KEYS - 1) != shared
+			|| total + shared != t.size)
+		errors += 1;
+	if (splay_health_check(&t, buf, sizeof buf)) {
+		fprintf(stderr, "%s\n", buf);
+		errors += 1;
+	}
+	splay_tree_dtor(&t);
+
+	if (errors)
+		return fail("combined operations disagree with the model");
+	printf("%u threads, %u operations each: ok\n", nthreads, ops);
+	return EXIT_SUCCESS;
+}
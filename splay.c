@@ -53,9 +53,12 @@
 	The implementation of the above is via the struct splay_Topdown object
 	and its associated methods.
 
-	This code does not offer an array-input constructor because it is not
-	necessary -- if you have a sorted array of records, just insert them one
-	by one.  The splay tree will only use linear time, unlike a naive BST.
+	If you have a sorted array of records, you could just insert them one
+	by one:  the splay tree will only use linear time, unlike a naive BST.
+	However, that leaves the tree as a long chain, which makes the first few
+	searches slow, and it costs one allocation per record.  So this code also
+	offers splay_tree_from_sorted(), which allocates all the nodes in one
+	block and builds a perfectly balanced tree in one linear pass.
 
 	Another design choice:  this code could work in a highly constrained
 	environment where printf and its stdio.h friends are unavailable.
@@ -65,10 +68,18 @@
 	the code with macro SPLAY_HAS_DOT_OUTPUT defined to be zero.
 
 	I did not offer the same options for stdlib.h because malloc() and free()
-	are pretty handy; however, they are only called once each in the program
-	text, so if you really want to use this in an IOT matchbox or shovel or
-	something, you could also peel off stdlib.h pretty easily if you do your
-	own memory allocation and define EXIT_SUCCESS and EXIT_FAILURE symbols. */
+	are pretty handy; however, they are only called by the default allocator,
+	so if you really want to use this in an IOT matchbox or shovel or
+	something, you could also peel off stdlib.h pretty easily if you
+	construct your trees with your own struct splay_Allocator (see
+	splay_tree_alloc_ctor) and define EXIT_SUCCESS and EXIT_FAILURE symbols.
+
+	Nodes are normally allocated one at a time.  A tree built by
+	splay_tree_slab_ctor() instead carves its nodes out of large chunks (a
+	"slab arena"), and recycles released nodes through an intrusive free list.
+	Then insert and erase cost only a pointer push or pop, the nodes are
+	packed densely in memory, and splay_tree_clear() can release the whole
+	arena one chunk at a time without visiting every node. */
 
 /*	$Id: splay.c 172 2018-07-21 01:42:09Z predoehl $
 	Tab size: 4
@@ -99,9 +110,9 @@
 #define _BSD_SOURCE /**< macro recognized by GCC to allow use of snprintf */
 #endif
 #include <stdio.h>
-#include <limits.h>
 #endif
 
+#include <limits.h>
 #include <stdlib.h> /* for malloc, free, EXIT_SUCCESS, stuff like that. */
 
 #include "splay.h"
@@ -122,6 +133,35 @@
 #define SPLAY_DEBUG 1
 #endif
 
+#ifndef SPLAY_ORDER_STAT
+/**	@brief Macro to control the order-statistic augmentation.
+
+	If this is set to a nonzero value at compile time, via flag
+	-DSPLAY_ORDER_STAT=1, then every node stores the number of nodes in its
+	subtree, and splay_select() and splay_rank() run in logarithmic amortized
+	time.  The price is a slightly bigger node and a little bookkeeping in
+	every rotation, which is why it is off by default.  When it is off,
+	splay_select() finds nothing and splay_rank() fails. */
+#define SPLAY_ORDER_STAT 0
+#endif
+
+#ifndef SPLAY_INTERVAL
+/**	@brief Macro to control the interval augmentation.
+
+	If this is set to a nonzero value at compile time, via flag
+	-DSPLAY_INTERVAL=1, then every record is a closed interval [key, hi],
+	and every node stores the maximum right endpoint in its subtree, so
+	splay_interval_overlap() can skip the subtrees that cannot overlap its
+	query.  Records inserted by the ordinary functions are the intervals
+	[key, key].  When it is off, splay_interval_insert() and
+	splay_interval_overlap() fail. */
+#define SPLAY_INTERVAL 0
+#endif
+
+/** Nonzero if nodes carry any fields derived from their subtrees, which
+	must be recomputed whenever the shape of the tree changes. */
+#define SPLAY_AUGMENTED (SPLAY_ORDER_STAT || SPLAY_AGGREGATE || SPLAY_INTERVAL)
+
 /** If SPLAY_DEBUG > 0 and SPLAY_VERBOSE > 0 then the code prints trace messages
 	to standard output. */
 #ifndef SPLAY_VERBOSE
@@ -167,8 +207,18 @@
 #define SPLAY_BLANK_RESULT	{0, 0, NULL}	/* found? key, sat */
 
 
-/** Release the memory for the current node.  In a macro for easy access. */
-#define FREENODE(n) free(n)
+/** Release the memory for node n of tree t.  In a macro for easy access. */
+#define FREENODE(t, n) \
+	((t) -> arena ? arena_release((t) -> arena, (n)) \
+		: (t) -> alloc.release((t) -> alloc.context, (n)))
+
+
+/** Default number of nodes per chunk of a slab arena. */
+#define SPLAY_SLAB_CHUNK 128
+
+
+/** Initial capacity of the path stored in a cursor. */
+#define SPLAY_CURSOR_DEPTH 64
 
 
 /* Key comparison is put into the next two macros so we can find them easily.
@@ -190,6 +240,18 @@
 #define KEYLESS(k,p) ((k) < (p) -> keiy)
 
 
+/** Direction test for searches that never stop at an equal key, but always
+	continue to the bottom of the tree.  Nodes with keys less than k go right,
+	and so do nodes with keys equal to k if 'inclusive' is true. */
+#define BOUND_RIGHT(p,k,inclusive) \
+	((inclusive) ? ! KEYLESS((k),(p)) : LESSKEY((p),(k)))
+
+
+/** Comparison of two bare keys, for the rare cases where neither is in a
+	node (such as validating input). */
+#define KEY_LT(a,b) ((a) < (b))
+
+
 /** @brief Basic BST node of the tree.  */
 struct splay_Node {
 
@@ -206,6 +268,57 @@ struct splay_Node {
 
 	/** Pointer to subtree of records with keys at least as large as 'key'. */
 	struct splay_Node *right;
+
+#if SPLAY_ORDER_STAT
+	/** Number of nodes in the subtree rooted here, including this one. */
+	unsigned count;
+#endif
+
+#if SPLAY_AGGREGATE
+	/** Aggregate of the records in the subtree rooted here, in key order. */
+	splay_Aggregate agg;
+#endif
+
+#if SPLAY_INTERVAL
+	/** Right endpoint of the interval [key, hi] of this record. */
+	splay_Key hi;
+
+	/** Greatest right endpoint in the subtree rooted here. */
+	splay_Key maxhi;
+#endif
+};
+
+
+/** @brief Block of contiguous nodes in a slab arena. */
+struct splay_Chunk {
+
+	/** Chunks of an arena form a singly linked list, newest first. */
+	struct splay_Chunk *next;
+
+	/** Storage for the nodes; the array really is longer than one. */
+	struct splay_Node node[1];
+};
+
+
+/**
+ * @brief Slab allocator for the nodes of one tree.
+ *
+ * Nodes are handed out from the newest chunk in order, via the "bump" pointer,
+ * until the chunk is used up.  Released nodes are pushed on the free list,
+ * threaded through their left fields, and they are reused before the bump
+ * pointer advances again.  Nodes are never returned to the heap individually:
+ * the chunks are released all together by arena_clear.
+ *
+ * After splay_split(), several trees may draw nodes from the same arena.
+ * Then the arena is only cleared when the last of them lets go of it.
+ */
+struct splay_Arena {
+	struct splay_Chunk *chunks;		/* list of all chunks, newest first */
+	struct splay_Node *free_list;	/* released nodes, linked through left */
+	struct splay_Node *bump;		/* next never-used node in newest chunk */
+	unsigned bump_left;				/* number of never-used nodes at bump */
+	unsigned chunk_nodes;			/* number of nodes per chunk */
+	unsigned refs;					/* number of trees using this arena */
 };
 
 
@@ -213,6 +326,50 @@ struct splay_Node {
 
 
 
+#if SPLAY_ORDER_STAT
+/** Number of nodes in the subtree at n, which may be NULL. */
+#define SUBTREE_COUNT(n) ((n) ? (n) -> count : 0)
+#endif
+
+#if SPLAY_AGGREGATE
+/** Aggregate of the records in the subtree at n, which may be NULL. */
+#define SUBTREE_AGG(n) ((n) ? (n) -> agg : SPLAY_AGG_IDENTITY)
+
+/** Aggregate that node n should have, given its children. */
+#define NODE_AGG(n) SPLAY_AGG_COMBINE(SPLAY_AGG_COMBINE(SUBTREE_AGG((n) -> left), \
+						SPLAY_AGG_LIFT((n) -> keiy, (n) -> sat)), \
+						SUBTREE_AGG((n) -> right))
+#endif
+
+#if SPLAY_INTERVAL
+/** Greater of right endpoint m and the greatest one in the subtree at c. */
+#define MAX_HI(m, c) ((c) && KEY_LT((m), (c) -> maxhi) ? (c) -> maxhi : (m))
+
+/** Greatest right endpoint that node n should have, given its children. */
+#define NODE_MAXHI(n) MAX_HI(MAX_HI((n) -> hi, (n) -> left), (n) -> right)
+#endif
+
+
+/* Recompute the augmented fields of node *n (if any) from its children,
+   whose own fields must be up to date. */
+static void node_pull(struct splay_Node* n)
+{
+	SPLAY_ASSERT(n);
+#if SPLAY_ORDER_STAT
+	n -> count = 1 + SUBTREE_COUNT(n -> left) + SUBTREE_COUNT(n -> right);
+#endif
+#if SPLAY_AGGREGATE
+	n -> agg = NODE_AGG(n);
+#endif
+#if SPLAY_INTERVAL
+	n -> maxhi = NODE_MAXHI(n);
+#endif
+#if ! SPLAY_AUGMENTED
+	(void) n;
+#endif
+}
+
+
 /**
  * Left rotation, where t points to the TOP of the rotated link.
  *
@@ -226,6 +383,8 @@ static struct splay_Node* left_rot(struct splay_Node* t)
 	t -> right = u -> left;
 	u -> left = t;
 
+	node_pull(t);
+	node_pull(u);
 	return u;
 }
 
@@ -244,26 +403,220 @@ static struct splay_Node* right_rot(struct splay_Node* t)
 	t -> left = s -> right;
 	s -> right = t;
 
+	node_pull(t);
+	node_pull(s);
 	return s;
 }
 
 
-/* Allocate and initialize a new BST node.  Return NULL if allocation fails. */
-static struct splay_Node* node_ctor(splay_Key k, splay_Satellite s)
+/* The default allocator just calls malloc. */
+static void* default_alloc(void* context, size_t size)
+{
+	(void) context;
+	return malloc(size);
+}
+
+
+/* The default allocator just calls free. */
+static void default_release(void* context, void* block)
+{
+	(void) context;
+	free(block);
+}
+
+
+/* Add a new chunk of 'count' nodes to the arena of tree *t, and make it the
+   source of never-used nodes.  Any never-used nodes left in the previous
+   chunk are moved to the free list.  Returns EXIT_SUCCESS or EXIT_FAILURE. */
+static int arena_grow(struct splay_Tree* t, unsigned count)
+{
+	struct splay_Arena* a = t -> arena;
+	struct splay_Chunk* c;
+	size_t bytes;
+	SPLAY_ASSERT(a && count > 0);
+
+	/* Refuse a chunk whose size in bytes would overflow size_t. */
+	bytes = (size_t) (count - 1) * sizeof(struct splay_Node);
+	if (bytes / sizeof(struct splay_Node) != count - 1
+			|| bytes > (size_t) -1 - sizeof(struct splay_Chunk))
+		return EXIT_FAILURE;
+
+	c = (struct splay_Chunk*) t -> alloc.alloc(t -> alloc.context,
+								sizeof(struct splay_Chunk) + bytes);
+	if (NULL == c)
+		return EXIT_FAILURE;
+
+	for ( ; a -> bump_left > 0; a -> bump_left -= 1) {
+		a -> bump -> left = a -> free_list;
+		a -> free_list = a -> bump++;
+	}
+
+	c -> next = a -> chunks;
+	a -> chunks = c;
+	a -> bump = c -> node;
+	a -> bump_left = count;
+	return EXIT_SUCCESS;
+}
+
+
+/* Give tree *t, which has no arena, an empty one with chunks of chunk_nodes
+   nodes, allocated through the tree's allocator. */
+static int arena_ctor(struct splay_Tree* t, unsigned chunk_nodes)
+{
+	SPLAY_ASSERT(t && NULL == t -> arena && chunk_nodes > 0);
+
+	t -> arena = (struct splay_Arena*) t -> alloc.alloc(t -> alloc.context,
+												sizeof(struct splay_Arena));
+	if (NULL == t -> arena)
+		return EXIT_FAILURE;
+
+	t -> arena -> chunks = NULL;
+	t -> arena -> free_list = t -> arena -> bump = NULL;
+	t -> arena -> bump_left = 0;
+	t -> arena -> chunk_nodes = chunk_nodes;
+	t -> arena -> refs = 1;
+	return EXIT_SUCCESS;
+}
+
+
+/* Get memory for one node from the arena of tree *t, or NULL on failure. */
+static struct splay_Node* arena_acquire(struct splay_Tree* t)
+{
+	struct splay_Arena* a = t -> arena;
+	struct splay_Node* n;
+
+	SPLAY_ASSERT(a);
+	if ((n = a -> free_list) != NULL) {
+		a -> free_list = n -> left;
+		return n;
+	}
+
+	if (0 == a -> bump_left && arena_grow(t, a -> chunk_nodes) != EXIT_SUCCESS)
+		return NULL;
+
+	a -> bump_left -= 1;
+	return a -> bump++;
+}
+
+
+/* Give node *n back to arena *a, for reuse.  Constant time. */
+static void arena_release(struct splay_Arena* a, struct splay_Node* n)
+{
+	SPLAY_ASSERT(a && n);
+	n -> left = a -> free_list;
+	a -> free_list = n;
+}
+
+
+/* Release every chunk of the arena of tree *t, leaving it empty but usable.
+   This takes time proportional to the number of chunks, not nodes. */
+static void arena_clear(struct splay_Tree* t)
+{
+	struct splay_Arena* a = t -> arena;
+	SPLAY_ASSERT(a);
+	while (a -> chunks) {
+		struct splay_Chunk* c = a -> chunks;
+		a -> chunks = c -> next;
+		t -> alloc.release(t -> alloc.context, c);
+	}
+	a -> free_list = a -> bump = NULL;
+	a -> bump_left = 0;
+}
+
+
+/* Allocate and initialize a new BST node for tree *t.
+   Return NULL if allocation fails. */
+static struct splay_Node* node_ctor(
+	struct splay_Tree* t,
+	splay_Key k,
+	splay_Satellite s
+)
 {
-	struct splay_Node *n
-		= (struct splay_Node*) malloc(sizeof(struct splay_Node));
+	struct splay_Node *n = t -> arena
+		? arena_acquire(t)
+		: (struct splay_Node*) t -> alloc.alloc(t -> alloc.context,
+												sizeof(struct splay_Node));
 
 	if (n) {
 		n -> keiy = k;
 		n -> sat = s;
 		n -> left = n -> right = NULL;
+#if SPLAY_INTERVAL
+		n -> hi = k;
+#endif
+		node_pull(n);
+	}
+	return n;
+}
+
+
+/* Allocate a node for tree *t holding a copy of the record of node *src. */
+static struct splay_Node* node_clone(
+	struct splay_Tree* t,
+	const struct splay_Node* src
+)
+{
+	struct splay_Node *n = node_ctor(t, src -> keiy, src -> sat);
+
+#if SPLAY_INTERVAL
+	if (n) {
+		n -> hi = src -> hi;
+		node_pull(n);
 	}
+#endif
 	return n;
 }
 
 
 
+/*	Build a perfectly balanced tree out of the first n nodes of a "vine," i.e.,
+	a list of nodes in nondecreasing key order linked through their right
+	fields.  *head advances past the nodes consumed, and the root is returned.
+
+	This takes linear time, and recursion depth is only about log2(n). */
+static struct splay_Node* vine_to_tree(struct splay_Node** head, unsigned n)
+{
+	struct splay_Node *left, *root;
+
+	if (0 == n)
+		return NULL;
+
+	left = vine_to_tree(head, n / 2);
+	root = *head;
+	SPLAY_ASSERT(root);
+	*head = root -> right;
+	root -> left = left;
+	root -> right = vine_to_tree(head, n - n / 2 - 1);
+	node_pull(root);
+	return root;
+}
+
+
+/*	Flatten the tree at *root into a vine (see vine_to_tree) by repeated right
+	rotations, and store the number of nodes in *count.  Linear time, constant
+	space.  Returns the head of the vine, i.e., the minimum node. */
+static struct splay_Node* tree_to_vine(
+	struct splay_Node* root,
+	unsigned* count
+)
+{
+	struct splay_Node *head = NULL, **tail = &head;
+
+	SPLAY_ASSERT(count);
+	for (*count = 0; root; )
+		if (root -> left)
+			root = right_rot(root);
+		else {
+			/* root is the minimum of what remains: append it to the vine. */
+			*tail = root;
+			tail = & root -> right;
+			root = root -> right;
+			*count += 1;
+		}
+
+	return head;
+}
+
 
 /** Symbolic constants to use with the splay_Topdown::history array. */
 enum td_history_keys { RIGHT_FIRST, LEFT_FIRST, RIGHT_2ND, LEFT_2ND,
@@ -524,6 +877,85 @@ static void topdown_set_aside(struct splay_Topdown *td)
 }
 
 
+#if SPLAY_AUGMENTED
+/*	Recompute the augmented fields of the nodes on the path from *n down the
+	right links until reaching *stop (which is not on the path), bottom up.
+	There are no parent pointers, so the right links are reversed on the way
+	down and restored on the way up.  Constant space.
+
+	This fixes the left remainder tree, whose nodes all lie on such a path,
+	and whose fields are stale because they were set aside before their
+	right subtrees were complete. */
+static void pull_right_spine(struct splay_Node* n, struct splay_Node* stop)
+{
+	struct splay_Node *up = NULL, *next;
+
+	while (n != stop) {
+		next = n -> right;
+		n -> right = up;
+		up = n;
+		n = next;
+	}
+	while (up) {
+		next = up -> right;
+		up -> right = n;
+		node_pull(up);
+		n = up;
+		up = next;
+	}
+}
+
+
+/* Mirror image of pull_right_spine, for the right remainder tree. */
+static void pull_left_spine(struct splay_Node* n, struct splay_Node* stop)
+{
+	struct splay_Node *up = NULL, *next;
+
+	while (n != stop) {
+		next = n -> left;
+		n -> left = up;
+		up = n;
+		n = next;
+	}
+	while (up) {
+		next = up -> left;
+		up -> left = n;
+		node_pull(up);
+		n = up;
+		up = next;
+	}
+}
+#endif
+
+
+/*	Final step of top-down splaying:  graft the subtrees of *root to the tips
+	of the remainder trees, and make the remainder trees the new subtrees of
+	*root.  (That is simply the standard recipe for top-down splaying.)
+	The history must be blank.  Returns root. */
+static struct splay_Node* topdown_assemble(
+	struct splay_Topdown* td,
+	struct splay_Node* root
+)
+{
+	struct splay_Node *l = root -> left, *r = root -> right;
+
+	SPLAY_ASSERT(is_td_history_blank(td));
+
+	* td -> rem[0].tip = l;
+	root -> left = td -> rem[0].root;
+
+	* td -> rem[1].tip = r;
+	root -> right = td -> rem[1].root;
+
+#if SPLAY_AUGMENTED
+	pull_right_spine(root -> left, l);
+	pull_left_spine(root -> right, r);
+	node_pull(root);
+#endif
+	return root;
+}
+
+
 /** This removes the non-NULL pointer in level-1 history, and returns it. */
 static struct splay_Node* undo_first_step(struct splay_Topdown* td)
 {
@@ -607,23 +1039,149 @@ int splay_tree_empty_ctor(struct splay_Tree *t)
 
 	t -> root = NULL;
 	t -> size = 0;
+	t -> arena = NULL;
+	t -> alloc.alloc = default_alloc;
+	t -> alloc.release = default_release;
+	t -> alloc.context = NULL;
 
 	return EXIT_SUCCESS;
 }
 
 
+/** @brief Initialize a raw tree object whose nodes come from a slab arena.
 
+	This is like splay_tree_empty_ctor(), except that the tree allocates
+	its nodes in chunks of 'chunk_nodes' nodes each, instead of calling
+	malloc() once per node.  Pass zero to get a reasonable default size.
+	Nodes released by splay_erase() are recycled by later insertions, and
+	splay_tree_clear() frees the chunks without walking the tree.
 
-/* Print the subtree rooted at this node *n, to stdout. */
-#if SPLAY_HAS_DOT_OUTPUT
-static void db_print_tree(
-	const struct splay_Node* n,
-	const struct splay_Node* emmpty,
-	int depth
+	Memory is returned to the heap only by splay_tree_clear() and
+	splay_tree_dtor(), so an arena tree never shrinks in between.
+
+	@returns EXIT_SUCCESS unless t is NULL or allocation fails.
+
+	@note This is a constructor function.
+	@see splay_tree_empty_ctor(), splay_tree_alloc_ctor() */
+int splay_tree_slab_ctor(struct splay_Tree *t, unsigned chunk_nodes)
+{
+	return splay_tree_alloc_ctor(t, NULL,
+								chunk_nodes ? chunk_nodes : SPLAY_SLAB_CHUNK);
+}
+
+
+/** @brief Initialize a raw tree object that uses a custom allocator.
+
+	@param t			Pointer to uninitialized tree object.
+	@param a			Allocator for all memory the tree needs, or NULL
+						to use malloc() and free().  The tree keeps a copy
+						of *a, so *a itself need not outlive this call,
+						but its context must outlive the tree.
+	@param chunk_nodes	Zero to request memory from *a one node at a time,
+						or else the number of nodes per chunk of a slab arena
+						(see splay_tree_slab_ctor), whose chunks and
+						bookkeeping come from *a.
+
+	@returns EXIT_SUCCESS unless t is NULL, *a lacks a function,
+	or allocation fails.
+
+	@note This is a constructor function.
+	@see splay_tree_empty_ctor() */
+int splay_tree_alloc_ctor(
+	struct splay_Tree *t,
+	const struct splay_Allocator *a,
+	unsigned chunk_nodes
 )
 {
-	if (n) {
-		int j = depth;
+	if (splay_tree_empty_ctor(t) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+
+	if (a) {
+		if (NULL == a -> alloc || NULL == a -> release)
+			return EXIT_FAILURE;
+		t -> alloc = *a;
+	}
+
+	return chunk_nodes ? arena_ctor(t, chunk_nodes) : EXIT_SUCCESS;
+}
+
+
+
+
+/** @brief Construct a balanced tree from arrays of records sorted by key.
+
+	@param t	Pointer to uninitialized tree object.
+	@param keys	Array of n keys in nondecreasing order.
+	@param sats	Array of n satellite values, where sats[i] goes with keys[i];
+				or NULL, in which case all satellite values are NULL.
+	@param n	Number of records.
+
+	The tree gets a slab arena (see splay_tree_slab_ctor), and all n nodes
+	are allocated in a single chunk.  The nodes are laid out in key order,
+	and linked into a perfectly balanced tree, in linear time.  So, unlike
+	inserting the records one at a time, the first searches are fast too.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE, e.g., if the keys are out of order
+	or memory allocation fails.  Even after failure, *t is a valid empty tree
+	(unless t is NULL) and should eventually be destroyed.
+
+	@note This is a constructor function. */
+int splay_tree_from_sorted(
+	struct splay_Tree *t,
+	const splay_Key keys[],
+	const splay_Satellite sats[],
+	unsigned n
+)
+{
+	struct splay_Node *head = NULL, **tail = &head;
+	unsigned i;
+
+	if (splay_tree_slab_ctor(t, 0) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	if (0 == n)
+		return EXIT_SUCCESS;
+
+	if (NULL == keys)
+		return EXIT_FAILURE;
+	for (i = 1; i < n; ++i)
+		if (KEY_LT(keys[i], keys[i-1]))
+			return EXIT_FAILURE;
+
+	if (arena_grow(t, n) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+
+	for (i = 0; i < n; ++i) {
+		*tail = node_ctor(t, keys[i], sats ? sats[i] : NULL);
+		SPLAY_ASSERT(*tail); /* cannot fail: arena has room for n nodes */
+		tail = & (*tail) -> right;
+	}
+
+	t -> root = vine_to_tree(&head, n);
+	SPLAY_ASSERT(NULL == head);
+	t -> size = n;
+
+	return EXIT_SUCCESS;
+}
+
+
+
+
+#if SPLAY_HAS_DOT_OUTPUT
+static const struct splay_Node* preorder_first(struct splay_Cursor* c);
+static const struct splay_Node* preorder_next(struct splay_Cursor* c);
+
+
+/* Print the nodes of tree *t, to stdout, in preorder.  The ancestors of each
+   node are kept in a cursor path, taken from the tree's allocator. */
+static void db_print_tree(const struct splay_Tree* t)
+{
+	const struct splay_Node* n;
+	struct splay_Cursor c;
+
+	splay_cursor_ctor(&c, t);
+
+	for (n = preorder_first(&c); n; n = preorder_next(&c)) {
+		unsigned j = c.depth - 1;
 		while (j --> 0)
 			putchar(' ');
 
@@ -631,9 +1189,10 @@ static void db_print_tree(
 				"left %p, right %p\n",
 				(void*) n, n -> keiy,
 				(void*) n -> left, (void*)n -> right);
-		db_print_tree(n -> left, emmpty, 1+depth);
-		db_print_tree(n -> right, emmpty, 1+depth);
 	}
+	if (c.failed)
+		printf("Out of memory; the listing is incomplete.\n");
+	splay_cursor_dtor(&c);
 }
 #endif
 
@@ -648,26 +1207,41 @@ void splay_debug_print_tree(const struct splay_Tree* t)
 #if SPLAY_HAS_DOT_OUTPUT
 	if (t) {
 		printf("Tree size: %d\n", t -> size);
-		db_print_tree(t -> root, NULL, 0);
+		db_print_tree(t);
 	}
+#else
+	(void) t;
 #endif
 }
 
 
+#if SPLAY_HAS_DOT_OUTPUT
 static const char* shape = "[shape=box;color=black;fontcolor=black;"
 							"style=filled;fillcolor=white]";
+#endif
 
 
 
-/* Postorder traverse and destroy the tree. */
+/* Destroy the subtree at *n, which belongs to *t.  Whenever the current node
+   has a left child we rotate right, otherwise it is the minimum and we free
+   it.  No recursion and constant space, so even a long chain is safe. */
 static
-void splay_dtor_helper(struct splay_Node* n)
+void splay_dtor_helper(struct splay_Tree* t, struct splay_Node* n)
 {
-	if (n) {
-		splay_dtor_helper(n -> left);
-		splay_dtor_helper(n -> right);
-		FREENODE(n);
-	}
+	struct splay_Node* y;
+
+	while (n)
+		if (n -> left) {
+			y = n -> left;
+			n -> left = y -> right;
+			y -> right = n;
+			n = y;
+		}
+		else {
+			y = n -> right;
+			FREENODE(t, n);
+			n = y;
+		}
 }
 
 
@@ -678,12 +1252,26 @@ void splay_dtor_helper(struct splay_Node* n)
 	@pre This is not a constructor: tree *t must have been initialized earlier.
 	If *t has not yet been initialized, call splay_tree_empty_ctor() instead.
 
+	If the tree has a slab arena, the arena chunks are released all together,
+	in time proportional to the number of chunks rather than nodes.
+	The tree keeps using its (now empty) arena afterwards.  But if the arena
+	is shared with other trees (see splay_split), the nodes are just put
+	back on its free list, one by one.
+
 	@returns EXIT_SUCCESS or EXIT_FAILURE (if t equals NULL). */
 int splay_tree_clear(struct splay_Tree* t)
 {
-	if (t)
-		splay_dtor_helper(t -> root);
-	return splay_tree_empty_ctor(t);
+	if (NULL == t)
+		return EXIT_FAILURE;
+
+	if (t -> arena && 1 == t -> arena -> refs)
+		arena_clear(t);
+	else
+		splay_dtor_helper(t, t -> root);
+
+	t -> root = NULL;
+	t -> size = 0;
+	return EXIT_SUCCESS;
 }
 
 
@@ -708,6 +1296,14 @@ void splay_tree_dtor(struct splay_Tree* t)
 		the return code from splay_tree_clear() is EXIT_FAILURE, i.e.,
 		undeservedly harsh and gloomy. */
 	splay_tree_clear(t);
+
+	if (t && t -> arena) {
+		if (0 == --t -> arena -> refs) {
+			arena_clear(t);
+			t -> alloc.release(t -> alloc.context, t -> arena);
+		}
+		t -> arena = NULL;
+	}
 }
 
 
@@ -735,12 +1331,10 @@ static int print_phantom(FILE* f, int parent_key)
 }
 
 
-/* Render the entire tree in DOT format, to a given stream, in linear time.
-
-   This is recursive.  It prints node *t each time it is called.
+/* Print node *t in DOT format, to a given stream.
    If *t also has a parent (*tpar) then print that edge too. */
 static
-int dot_out_help(
+int dot_out_node(
 	const struct splay_Node* t,
 	const struct splay_Node* tpar,
 	FILE* f
@@ -772,16 +1366,29 @@ int dot_out_help(
 				return EXIT_FAILURE;
 	}
 
-	if (t) {
-		/* recurse */
-		if (dot_out_help(t -> left, t, f) != EXIT_SUCCESS)
-			return EXIT_FAILURE;
-		if (dot_out_help(t -> right, t, f) != EXIT_SUCCESS)
-			return EXIT_FAILURE;
-	}
-
 	return EXIT_SUCCESS;
 }
+
+
+/* Render the entire tree in DOT format, to a given stream, in linear time.
+   Nodes are visited in preorder, with the ancestors kept in a cursor path
+   rather than on the call stack. */
+static
+int dot_out_help(const struct splay_Tree* t, FILE* f)
+{
+	struct splay_Cursor c;
+	const struct splay_Node* n;
+	int rc = EXIT_SUCCESS;
+
+	splay_cursor_ctor(&c, t);
+	for (n = preorder_first(&c); n && EXIT_SUCCESS == rc; n = preorder_next(&c))
+		rc = dot_out_node(n, c.depth > 1 ? c.path[c.depth - 2] : NULL, f);
+
+	if (c.failed)
+		rc = EXIT_FAILURE;
+	splay_cursor_dtor(&c);
+	return rc;
+}
 #endif
 
 
@@ -809,7 +1416,7 @@ int splay_dot_output(const struct splay_Tree* t, const char* filename)
 		if (f) {
 			if (0 <= fputs("digraph {\n  bgcolor=lightblue;\n", f)) {
 				if (EXIT_SUCCESS ==
-						(rc = dot_out_help(t -> root, NULL, f)))
+						(rc = dot_out_help(t, f)))
 					if (EOF == fputs("}\n", f))
 						rc = EXIT_FAILURE;
 			}
@@ -817,6 +1424,9 @@ int splay_dot_output(const struct splay_Tree* t, const char* filename)
 				rc = EXIT_FAILURE;
 		}
 	}
+#else
+	(void) t;
+	(void) filename;
 #endif
 	return rc;
 }
@@ -833,11 +1443,11 @@ const struct splay_Topdown* db_print_splay_td(const struct splay_Topdown* td)
 	puts("Start db_print_splay_td");
 
 	puts("Left remainder tree:");
-	db_print_tree(td -> rem[0].root, NULL, 0);
+	db_print_tree(td -> rem[0].root);
 	printf("Left tip is: %p\n", td -> rem[0].tip);
 
 	puts("Right remainder tree:");
-	db_print_tree(td -> rem[1].root, NULL, 0);
+	db_print_tree(td -> rem[1].root);
 	printf("Right tip is: %p\n", td -> rem[1].tip);
 
 	puts("History:");
@@ -887,7 +1497,7 @@ struct splay_Node* search_and_splay(
 #if SPLAY_DEBUG && SPLAY_VERBOSE
 	SPLAY_VERBOSE_PUTS(__func__);
 	SPLAY_VERBOSE_PUTS("Here is the input tree:");
-	db_print_tree(root, NULL, 0);
+	db_print_tree(root);
 	SPLAY_VERBOSE_PUTS("----End of tree----");
 #endif
 
@@ -970,28 +1580,81 @@ struct splay_Node* search_and_splay(
 	 * *root, which is now at the root of the tree, just as its name implies.
 	 * The subtrees of *root should be attached to the working tips
 	 * of the corresponding remainder trees, and the remainder trees
-	 * become the new subtrees of *root.  (That is simply the standard recipe
-	 * for top-down splaying.)
+	 * become the new subtrees of *root.
 	 */
-	* td.rem[0].tip = root -> left;
-	root -> left = td.rem[0].root;
-
-	* td.rem[1].tip = root -> right;
-	root -> right = td.rem[1].root;
+	root = topdown_assemble(&td, root);
 
 	SPLAY_VERBOSE_PUTS("Exiting search-and-splay");
 	return root;
 }
 
 
-struct splay_Result splay_find(struct splay_Tree *t, splay_Key k)
-{
-	struct splay_Result r = SPLAY_BLANK_RESULT;
+/*	Search all the way to the bottom of the tree, without stopping for equal
+	keys, steering by BOUND_RIGHT, and splay the last node queried.
 
-	if (t) {
-	   	t -> root = search_and_splay(t -> root, k, & r.found);
-		if (r.found) {
-			r.key = k;
+	@returns updated root to the tree, using the x=change(x) idiom.
+
+	@post If the tree is nonempty, its new root is either the last node (in
+	key order) that steers right, or the first node that steers left.
+	In the former case, the root's right subtree consists of nodes that steer
+	left, and in the latter case the left subtree consists of nodes that steer
+	right.  So, the predecessor and successor of key k are either at the root
+	or one zig away from it.
+
+	The loop is like that of search_and_splay, minus the exits for success. */
+static
+struct splay_Node* bound_and_splay(
+	struct splay_Node* root,
+	splay_Key k,
+	int inclusive
+)
+{
+	struct splay_Topdown td;
+
+	if (NULL == root)
+		return NULL;
+
+	for (initialize_topdown(&td); 1; topdown_set_aside(&td)) {
+
+		SPLAY_ASSERT(root);
+
+		if (BOUND_RIGHT(root, k, inclusive))
+			STEP_RIGHT_FIRST(td, root);
+		else
+			STEP_LEFT_FIRST(td, root);
+
+		if (NULL == root) {
+			root = undo_first_step(&td);
+			break;
+		}
+
+		if (BOUND_RIGHT(root, k, inclusive))
+			STEP_RIGHT_2ND(td, root);
+		else
+			STEP_LEFT_2ND(td, root);
+
+		if (NULL == root) {
+			root = undo_2nd_step(&td);
+			break;
+		}
+	}
+
+	/* Possible final zig. */
+	if (! is_td_history_blank(&td))
+		topdown_set_aside(&td);
+
+	return topdown_assemble(&td, root);
+}
+
+
+struct splay_Result splay_find(struct splay_Tree *t, splay_Key k)
+{
+	struct splay_Result r = SPLAY_BLANK_RESULT;
+
+	if (t) {
+	   	t -> root = search_and_splay(t -> root, k, & r.found);
+		if (r.found) {
+			r.key = k;
 			r.sat = t -> root -> sat;
 		}
 	}
@@ -999,13 +1662,204 @@ struct splay_Result splay_find(struct splay_Tree *t, splay_Key k)
 }
 
 
-/** @brief Search for the maximum element in the tree (which we splay).
- *
- * Implementation: the splaying code is simpler because all nodes we encounter
- * are either the new root, or they go in the right remainder tree.  There are
- * no comparisons and nothing in the left remainder tree.  So the code is
- * simpler.
- */
+/* A key of a batch, and its position in the caller's array. */
+struct batch_Entry
+{
+	splay_Key key;
+	unsigned index;
+};
+
+
+/* qsort comparison function for batch entries, ordering them by key, and
+   entries with equal keys by position, so the order is deterministic. */
+static int batch_entry_cmp(const void* a, const void* b)
+{
+	const struct batch_Entry *x = (const struct batch_Entry*) a,
+							 *y = (const struct batch_Entry*) b;
+	if (KEY_LT(x -> key, y -> key))
+		return -1;
+	if (KEY_LT(y -> key, x -> key))
+		return 1;
+	return x -> index < y -> index ? -1 : x -> index > y -> index;
+}
+
+
+/*	Get scratch space for n batch entries from the allocator of tree *t.
+	Returns NULL on failure, including when the size in bytes would
+	overflow size_t. */
+static struct batch_Entry* batch_alloc(struct splay_Tree* t, unsigned n)
+{
+	size_t bytes = (size_t) n * sizeof(struct batch_Entry);
+
+	if (bytes / sizeof(struct batch_Entry) != n)
+		return NULL;
+	return (struct batch_Entry*) t -> alloc.alloc(t -> alloc.context, bytes);
+}
+
+
+/** @brief Find many keys at once, visiting them in key order.
+
+	@param t		Tree to search (it is splayed)
+	@param keys		Array of n keys to find, in any order
+	@param n		Number of keys
+	@param[out] results	Array of n results; results[i] is what splay_find()
+					would have returned for keys[i]
+
+	After a key is splayed to the root, the next larger key is close to
+	the root, so visiting the batch in key order makes each search short.
+	By the dynamic finger property of splay trees, m keys spread across a
+	tree of n records cost O(m log(n/m)) amortized, rather than O(m log n).
+	Repeated keys are only searched once.
+
+	If the keys are not already in nondecreasing order, this sorts a copy of
+	them, using memory from the allocator of *t.  If that memory cannot be
+	had, the keys are searched in the given order instead; the results are
+	the same either way.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (if any argument is NULL). */
+int splay_find_batch(
+	struct splay_Tree *t,
+	const splay_Key keys[],
+	unsigned n,
+	struct splay_Result results[]
+)
+{
+	struct batch_Entry* order = NULL;
+	unsigned i, j, prev = 0;
+
+	if (NULL == t || (n > 0 && (NULL == keys || NULL == results)))
+		return EXIT_FAILURE;
+
+	for (i = 1; i < n && ! KEY_LT(keys[i], keys[i - 1]); ++i)
+		;
+	if (i < n && NULL != (order = batch_alloc(t, n))) {
+		for (i = 0; i < n; ++i) {
+			order[i].key = keys[i];
+			order[i].index = i;
+		}
+		qsort(order, n, sizeof(*order), batch_entry_cmp);
+	}
+
+	for (i = 0; i < n; ++i) {
+		j = order ? order[i].index : i;
+		if (i > 0 && ! KEY_LT(keys[prev], keys[j])
+				&& ! KEY_LT(keys[j], keys[prev]))
+			results[j] = results[prev];
+		else
+			results[j] = splay_find(t, keys[j]);
+		prev = j;
+	}
+
+	if (order)
+		t -> alloc.release(t -> alloc.context, order);
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Find a record with key k, without splaying.
+
+	This is a reader in the sense of the reader/writer contract in splay.h,
+	so concurrent calls on one tree are safe if no writer is active.
+	If the tree holds several records with key k, this finds one of them.
+
+	@returns a result with found set iff key k is present. */
+struct splay_Result splay_peek(const struct splay_Tree *t, splay_Key k)
+{
+	struct splay_Result r = SPLAY_BLANK_RESULT;
+	const struct splay_Node* n;
+
+	for (n = t ? t -> root : NULL; n; )
+		if (LESSKEY(n, k))
+			n = n -> right;
+		else if (KEYLESS(k, n))
+			n = n -> left;
+		else {
+			r.found = 1;
+			r.key = k;
+			r.sat = n -> sat;
+			break;
+		}
+	return r;
+}
+
+
+/** @brief Test whether key k is present, without splaying.
+
+	@returns a boolean value.
+	@see splay_peek() */
+int splay_contains(const struct splay_Tree *t, splay_Key k)
+{
+	return splay_peek(t, k).found;
+}
+
+
+/*	Splay the minimum node of the nonempty tree at *root to the root.
+
+	@returns updated root to the tree, using the x=change(x) idiom.
+
+	Implementation: the splaying code is simpler because all nodes we encounter
+	are either the new root, or they go in the right remainder tree.  There are
+	no comparisons and nothing in the left remainder tree.  So the code is
+	simpler. */
+static struct splay_Node* min_and_splay(register struct splay_Node* root)
+{
+	struct splay_Topdown td;
+	SPLAY_ASSERT(root);
+
+	/* Walk down the left links from root to the last node;
+	 * store all nodes in the right remainder tree.  The loop body
+	 * does this two links at a time (unless there is just one).
+	 */
+	for (initialize_topdown(&td); root -> left; topdown_set_aside(&td)) {
+		STEP_LEFT_FIRST(td, root);
+		if (root -> left)
+			STEP_LEFT_2ND(td, root);
+	}
+
+	/* Now *root is the deepest node in that chain of left links.
+	 * By the BST property, that means *root is the minimum node.  (For if
+	 * there were a node with a smaller key, it would be in the left
+	 * subtree of *root.  Which is absurd: it is empty.)
+	 */
+	SPLAY_ASSERT(root && NULL == root -> left);
+
+	/* Almost all the other nodes are now in the right remainder tree,
+	 * except for *root's right subtree, which we now graft to the tip,
+	 * and graft the right remainder tree as root's right subtree.
+	 * The left remainder tree is empty.
+	 */
+	SPLAY_ASSERT(NULL == td.rem[0].root);
+	return topdown_assemble(&td, root);
+}
+
+
+/*	Splay the maximum node of the nonempty tree at *root to the root.
+
+	@returns updated root to the tree, using the x=change(x) idiom. */
+static struct splay_Node* max_and_splay(register struct splay_Node* root)
+{
+	struct splay_Topdown td;
+	SPLAY_ASSERT(root);
+
+	/* See the comments for min_and_splay for a complete exegesis.
+	 * We walk down the chain of rightward links and store everything
+	 * in the left remainder tree.
+	 */
+	for (initialize_topdown(&td); root -> right; topdown_set_aside(&td)) {
+		STEP_RIGHT_FIRST(td, root);
+		if (root -> right)
+			STEP_RIGHT_2ND(td, root);
+	}
+
+	SPLAY_ASSERT(root && NULL == root -> right);
+
+	/* The right remainder tree is empty. */
+	SPLAY_ASSERT(NULL == td.rem[1].root);
+	return topdown_assemble(&td, root);
+}
+
+
+/** @brief Search for the minimum element in the tree (which we splay). */
 struct splay_Result splay_min(struct splay_Tree *t)
 {
 	struct splay_Result r = SPLAY_BLANK_RESULT;
@@ -1013,259 +1867,1711 @@ struct splay_Result splay_min(struct splay_Tree *t)
 	if (NULL == t || NULL == t -> root)
 		r.found = 0;
 	else {
-		register struct splay_Node* root = t -> root;
-		struct splay_Topdown td;
+		t -> root = min_and_splay(t -> root);
+
+		/* Fill in the result object. */
+		r.found = 1;
+		r.key = t -> root -> keiy;
+		r.sat = t -> root -> sat;
+	}
+
+	return r;
+}
+
+
+/* Is *n a leaf holding key k? */
+#define LEAF_WITH_KEY(n, k)	(NULL == (n) -> left && NULL == (n) -> right \
+							&& ! LESSKEY(n, k) && ! KEYLESS(k, n))
+
+
+/*	Search for key k and unlink a node holding it, in one top-down pass.
+
+	@param		root	Root of the entire tree
+	@param		k		Key that is sought
+	@param[out]	victim	Receives the unlinked node, or NULL if k is absent
+
+	@returns updated root to the tree, using the x=change(x) idiom.
+
+	The descent is that of search_and_splay, until it reaches the target x.
+	If x has a right subtree, the same descent then continues down the left
+	spine of that subtree to the successor s of x, putting the spine into
+	the right remainder tree, just as min_and_splay would.  Then s, which has
+	no left child, adopts the left subtree of x, and the remainder trees are
+	assembled once, around s.  If x has only a left subtree, the predecessor
+	takes its place likewise.
+
+	If x is a leaf, it has nothing to be replaced with, so it is caught one
+	step early:  when the descent reaches a leaf holding k, the leaf is
+	simply cut from its parent, which is splayed instead, as though the
+	search had failed there.  Either way, there is one descent and one
+	assembly.  If k is absent, this splays like search_and_splay. */
+static
+struct splay_Node* erase_and_splay(
+	struct splay_Node* root,
+	splay_Key k,
+	struct splay_Node** victim
+)
+{
+	struct splay_Topdown td;
+	struct splay_Node* x;
+
+	SPLAY_ASSERT(victim);
+	*victim = NULL;
+	if (NULL == root)
+		return NULL;
+
+	/* The loop of search_and_splay, plus the exits for leaf targets. */
+	for (initialize_topdown(&td); 1; topdown_set_aside(&td)) {
+
 		SPLAY_ASSERT(root);
 
-		/* Walk down the left links from t -> root to the last node;
-		 * store all nodes in the right remainder tree.  The loop body
-		 * does this two links at a time (unless there is just one).
-		 */
-		for (initialize_topdown(&td); root -> left; topdown_set_aside(&td)) {
+		/* First step down? */
+		if (LESSKEY(root, k))
+			STEP_RIGHT_FIRST(td, root);
+		else if (KEYLESS(k, root))
 			STEP_LEFT_FIRST(td, root);
-			if (root -> left)
-				STEP_LEFT_2ND(td, root);
+		else {
+			*victim = root;		/* found at root */
+			break;
+		}
+
+		if (NULL == root) {
+			root = undo_first_step(&td);
+			break;				/* not found */
+		}
+
+		/* Second step down? */
+		if (LESSKEY(root, k))
+			STEP_RIGHT_2ND(td, root);
+		else if (KEYLESS(k, root))
+			STEP_LEFT_2ND(td, root);
+		else if (root -> left || root -> right) {
+			*victim = root;		/* found at root's child */
+			break;
+		}
+		else {
+			/* Found a leaf at root's child:  cut it from its parent. */
+			*victim = root;
+			root = undo_first_step(&td);
+			if (root -> right == *victim)
+				root -> right = NULL;
+			else
+				root -> left = NULL;
+			break;
+		}
+
+		if (NULL == root) {
+			root = undo_2nd_step(&td);
+			break;				/* not found */
 		}
 
-		/* Now *root is the deepest node in that chain of left links.
-		 * By the BST property, that means *root is the minimum node.  (For if
-		 * there were a node with a smaller key, it would be in the left
-		 * subtree of *root.  Which is absurd: it is empty.)
-		 */
-		SPLAY_ASSERT(root && NULL == root -> left);
+		if (LEAF_WITH_KEY(root, k)) {
+			/* Found a leaf at root's grandchild:  cut it from its parent. */
+			*victim = root;
+			root = undo_2nd_step(&td);
+			if (root -> right == *victim)
+				root -> right = NULL;
+			else
+				root -> left = NULL;
+			break;
+		}
+	}
 
-		/* Almost all the other nodes are now in the right remainder tree,
-		 * except for *root's right subtree, which we now graft to the tip.
-		 */
-		* td.rem[1].tip = root -> right;
+	/* Possible final zig. */
+	if (! is_td_history_blank(&td))
+		topdown_set_aside(&td);
 
-		/* Now graft the right remainder tree as root's right subtree. */
-		root -> right = td.rem[1].root;
+	/* Unless the target is at root and still linked, we are done. */
+	if (*victim != root)
+		return topdown_assemble(&td, root);
 
-		/* Don't bother with the left remainder tree because it is empty. */
-		SPLAY_ASSERT(NULL == td.rem[0].root);
+	/* Then root is x.  Replace it by its successor, if any. */
+	x = root;
+	if (x -> right) {
+		for (root = x -> right; root -> left; topdown_set_aside(&td)) {
+			STEP_LEFT_FIRST(td, root);
+			if (root -> left)
+				STEP_LEFT_2ND(td, root);
+		}
+		root -> left = x -> left;
+	}
 
-		/* Copy the root local variable back into the tree.  There wasn't
-		 * any real need to copy it to a local variable except that it makes
-		 * the code a bit more concise.
-		 */
-		t -> root = root;
+	/* Or by its predecessor. */
+	else if (x -> left)
+		for (root = x -> left; root -> right; topdown_set_aside(&td)) {
+			STEP_RIGHT_FIRST(td, root);
+			if (root -> right)
+				STEP_RIGHT_2ND(td, root);
+		}
 
-		/* Fill in the result object. */
-		r.found = 1;
-		r.key = root -> keiy;
-		r.sat = root -> sat;
+	/* Or by nothing:  x is a lone leaf, the whole tree. */
+	else {
+		SPLAY_ASSERT(NULL == td.rem[0].root && NULL == td.rem[1].root);
+		return NULL;
 	}
 
-	return r;
+	return topdown_assemble(&td, root);
 }
 
 
 int splay_erase(struct splay_Tree *t, splay_Key k, splay_Satellite *psat)
 {
 	struct splay_Node* radix;
-	struct splay_Result r = splay_find(t, k);
 
-	if (! r.found)
+	if (NULL == t)
 		return EXIT_FAILURE;
 
-	SPLAY_ASSERT(r.key == k);
-	SPLAY_ASSERT(t && t -> root && t -> root -> keiy == k);
-	SPLAY_ASSERT(r.sat == t -> root -> sat);
+	/* Unlink the target (if present) and splay its replacement to the root. */
+	t -> root = erase_and_splay(t -> root, k, &radix);
+	if (NULL == radix)
+		return EXIT_FAILURE;
 
 	/* Save the satellite data if the user asked us to (via write param) */
 	if (psat)
-		*psat = r.sat;
+		*psat = radix -> sat;
 
-	/* Temporarily store the root (which is the target to delete). */
-	radix = t -> root;
+	FREENODE(t, radix);
 
-	/* Splay the root's successor s (if it exists) -- we do so by temporarily
-	 * reducing the tree to just the right subtree of *radix, and splay its
-	 * min elt, which must be s.
-	 *
-	 * Then the left subtree of *radix becomes the left subtree of s.
-	 */
-	if ((t -> root = t -> root -> right) != NULL) {
-		struct splay_Result succ = splay_min(t);
-		SPLAY_ASSERT(succ.found && t -> root && NULL == t -> root -> left);
-		t -> root -> left = radix -> left;
+	t -> size -= 1;
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Search for the maximum element in the tree (which we splay).
+ *
+ * If you want to extract the maximum element, call splay_pop_max() instead,
+ * which is cheaper than a search followed by an erase.
+ */
+struct splay_Result splay_max(struct splay_Tree *t)
+{
+	struct splay_Result r = SPLAY_BLANK_RESULT;
+
+	if (NULL == t || NULL == t -> root)
+		r.found = 0;
+	else {
+		t -> root = max_and_splay(t -> root);
+
+		r.found = 1;
+		r.key = t -> root -> keiy;
+		r.sat = t -> root -> sat;
+	}
+
+	return r;
+}
+
+
+/*	Support for the predecessor and successor queries:  splay the last node
+	that steers right (if want_pred) or the first node that steers left
+	(otherwise), using bound_and_splay and maybe one more zig. */
+static
+struct splay_Result neighbor_helper(
+	struct splay_Tree *t,
+	splay_Key k,
+	int inclusive,
+	int want_pred
+)
+{
+	struct splay_Result r = SPLAY_BLANK_RESULT;
+	struct splay_Node *root;
+
+	if (NULL == t || NULL == t -> root)
+		return r;
+
+	root = bound_and_splay(t -> root, k, inclusive);
+
+	if (! BOUND_RIGHT(root, k, inclusive) == ! want_pred)
+		r.found = 1;	/* the neighbor is at the root already */
+	else if (want_pred && root -> left) {
+		root -> left = max_and_splay(root -> left);
+		root = right_rot(root);
+		r.found = 1;
+	}
+	else if (! want_pred && root -> right) {
+		root -> right = min_and_splay(root -> right);
+		root = left_rot(root);
+		r.found = 1;
+	}
+
+	t -> root = root;
+	if (r.found) {
+		r.key = root -> keiy;
+		r.sat = root -> sat;
+	}
+	return r;
+}
+
+
+/** @brief Find the record with the greatest key less than k, and splay it.
+
+	If several records have that key, the last one in the tree order is found.
+	@see splay_find_pred_eq() for the non-strict version. */
+struct splay_Result splay_find_pred(struct splay_Tree *t, splay_Key k)
+{
+	return neighbor_helper(t, k, 0, 1);
+}
+
+
+/** @brief Find the record with the greatest key not exceeding k, and splay it.
+	@see splay_find_pred() */
+struct splay_Result splay_find_pred_eq(struct splay_Tree *t, splay_Key k)
+{
+	return neighbor_helper(t, k, 1, 1);
+}
+
+
+/** @brief Find the record with the least key greater than k, and splay it.
+
+	If several records have that key, the first one in the tree order is found.
+	@see splay_find_succ_eq() for the non-strict version. */
+struct splay_Result splay_find_succ(struct splay_Tree *t, splay_Key k)
+{
+	return neighbor_helper(t, k, 1, 0);
+}
+
+
+/** @brief Find the record with the least key not less than k, and splay it.
+	@see splay_find_succ() */
+struct splay_Result splay_find_succ_eq(struct splay_Tree *t, splay_Key k)
+{
+	return neighbor_helper(t, k, 0, 0);
+}
+
+
+/*	Splay the node of rank k (counting from zero) in the tree at root, which
+	must have more than k nodes.  This is like search_and_splay, but it
+	steers by subtree counts instead of keys, and it cannot fail. */
+#if SPLAY_ORDER_STAT
+static
+struct splay_Node* select_and_splay(struct splay_Node* root, unsigned k)
+{
+	struct splay_Topdown td;
+	unsigned c;
+
+	SPLAY_ASSERT(root && k < root -> count);
+
+	for (initialize_topdown(&td); 1; topdown_set_aside(&td)) {
+
+		SPLAY_ASSERT(root && k < root -> count);
+
+		if (k < (c = SUBTREE_COUNT(root -> left)))
+			STEP_LEFT_FIRST(td, root);
+		else if (k > c) {
+			k -= c + 1;
+			STEP_RIGHT_FIRST(td, root);
+		}
+		else
+			break;
+
+		SPLAY_ASSERT(root && k < root -> count);
+
+		if (k < (c = SUBTREE_COUNT(root -> left)))
+			STEP_LEFT_2ND(td, root);
+		else if (k > c) {
+			k -= c + 1;
+			STEP_RIGHT_2ND(td, root);
+		}
+		else
+			break;
+	}
+
+	if (! is_td_history_blank(&td))
+		topdown_set_aside(&td);
+
+	return topdown_assemble(&td, root);
+}
+#endif
+
+
+/** @brief Find the record of rank k, i.e., the (k+1)th smallest, and splay it.
+
+	Rank counts from zero, so rank 0 is the minimum and rank (size-1) is the
+	maximum.  If several records have equal keys, each has its own rank,
+	in the tree order.
+
+	Time complexity: O(log n) amortized, if the code is compiled with
+	@ref SPLAY_ORDER_STAT nonzero.  Otherwise this always finds nothing. */
+struct splay_Result splay_select(struct splay_Tree *t, unsigned k)
+{
+	struct splay_Result r = SPLAY_BLANK_RESULT;
+
+#if SPLAY_ORDER_STAT
+	if (t && k < t -> size) {
+		t -> root = select_and_splay(t -> root, k);
+		r.found = 1;
+		r.key = t -> root -> keiy;
+		r.sat = t -> root -> sat;
+	}
+#else
+	(void) t;
+	(void) k;
+#endif
+	return r;
+}
+
+
+/** @brief Count the records with keys less than k, with splaying.
+
+	@param t			Tree to query
+	@param k			Key to rank
+	@param[out] rank	Number of records in the tree with keys less than k.
+						That is also the rank of the first record with key k,
+						if there is one (see splay_select).
+
+	Time complexity: O(log n) amortized.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE, e.g., if the code was compiled
+	with macro @ref SPLAY_ORDER_STAT equal to zero. */
+int splay_rank(struct splay_Tree *t, splay_Key k, unsigned* rank)
+{
+#if SPLAY_ORDER_STAT
+	if (NULL == t || NULL == rank)
+		return EXIT_FAILURE;
+
+	*rank = 0;
+	if (t -> root) {
+		t -> root = bound_and_splay(t -> root, k, 0);
+		*rank = SUBTREE_COUNT(t -> root -> left)
+				+ (LESSKEY(t -> root, k) ? 1 : 0);
+	}
+	return EXIT_SUCCESS;
+#else
+	(void) t;
+	(void) k;
+	(void) rank;
+	return EXIT_FAILURE;
+#endif
+}
+
+
+/*	Support for splay_pop_min and splay_pop_max:  splay the minimum or maximum
+	node to the root in one spine walk, then splice it out, which is easy
+	because it has at most one child. */
+static int pop_helper(
+	struct splay_Tree *t,
+	int want_min,
+	splay_Key *pk,
+	splay_Satellite *psat
+)
+{
+	struct splay_Node* radix;
+
+	if (NULL == t || NULL == t -> root)
+		return EXIT_FAILURE;
+
+	if (want_min) {
+		radix = min_and_splay(t -> root);
+		SPLAY_ASSERT(NULL == radix -> left);
+		t -> root = radix -> right;
+	}
+	else {
+		radix = max_and_splay(t -> root);
+		SPLAY_ASSERT(NULL == radix -> right);
+		t -> root = radix -> left;
+	}
+
+	if (pk)
+		*pk = radix -> keiy;
+	if (psat)
+		*psat = radix -> sat;
+
+	FREENODE(t, radix);
+	t -> size -= 1;
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Remove the record with the minimum key, and report its contents.
+
+	@param t			Tree to modify
+	@param[out] pk		Pointer to storage for the key, or NULL
+	@param[out] psat	Pointer to storage for the satellite data, or NULL
+
+	This walks the left spine just once, so it is about half the work of
+	splay_min() followed by splay_erase().  It suits priority-queue usage.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (if the tree is empty). */
+int splay_pop_min(struct splay_Tree *t, splay_Key *pk, splay_Satellite *psat)
+{
+	return pop_helper(t, 1, pk, psat);
+}
+
+
+/** @brief Remove the record with the maximum key, and report its contents.
+	@see splay_pop_min() */
+int splay_pop_max(struct splay_Tree *t, splay_Key *pk, splay_Satellite *psat)
+{
+	return pop_helper(t, 0, pk, psat);
+}
+
+
+/* Test whether a node is a leaf in a BST sense. */
+static int is_bst_leaf(const struct splay_Node* n)
+{
+	return n && NULL == n -> left && NULL == n -> right;
+}
+
+
+/* This is also a simple kind of splaying -- we just rip the tree in half
+ * according to the new node's key, until root becomes null.  Then glue
+ * the remainder trees onto n. */
+static
+struct splay_Node* insert_and_splay(
+	struct splay_Node* root,
+	struct splay_Node* n
+)
+{
+	/* Storage for state during top-down splaying. */
+	struct splay_Topdown td;
+
+	/* Special case for simplicity. */
+	if (NULL == root)
+		return n;
+
+	/* Partition ALL old nodes into the left and right remainder trees. */
+	for (initialize_topdown(&td); root; topdown_set_aside(&td)) {
+
+		SPLAY_ASSERT(root);
+
+		if (LESSKEY(root, n -> keiy))
+			STEP_RIGHT_FIRST(td, root);
+		else
+			STEP_LEFT_FIRST(td, root);
+
+		if (root) {
+			if (LESSKEY(root, n -> keiy))
+				STEP_RIGHT_2ND(td, root);
+			else
+				STEP_LEFT_2ND(td, root);
+		}
+	}
+
+	/* Graft the remainder trees onto the new node n -- hail the new root! */
+	SPLAY_ASSERT(is_bst_leaf(n));
+	return topdown_assemble(&td, n);
+}
+
+
+/*	Split the tree at root into two trees, by top-down splaying towards key k.
+	This is the same as insert_and_splay, minus the new node.
+
+	@param		root		Pointer to the root of the entire tree
+	@param		k			Key at which to split
+	@param		inclusive	Boolean:  which side do nodes with key k go to?
+	@param[out]	lo			Root of tree of all nodes with keys less than k,
+							or not exceeding k if 'inclusive' is true.
+	@param[out]	hi			Root of tree of all the other nodes.
+
+	Every key in *lo is less than or equal to every key in *hi. */
+static
+void split_and_splay(
+	struct splay_Node* root,
+	splay_Key k,
+	int inclusive,
+	struct splay_Node** lo,
+	struct splay_Node** hi
+)
+{
+	struct splay_Topdown td;
+
+	SPLAY_ASSERT(lo && hi);
+
+	/* Partition ALL nodes into the left and right remainder trees. */
+	for (initialize_topdown(&td); root; topdown_set_aside(&td)) {
+
+		if (BOUND_RIGHT(root, k, inclusive))
+			STEP_RIGHT_FIRST(td, root);
+		else
+			STEP_LEFT_FIRST(td, root);
+
+		if (root) {
+			if (BOUND_RIGHT(root, k, inclusive))
+				STEP_RIGHT_2ND(td, root);
+			else
+				STEP_LEFT_2ND(td, root);
+		}
+	}
+
+	*lo = td.rem[0].root;
+	*hi = td.rem[1].root;
+
+#if SPLAY_AUGMENTED
+	pull_right_spine(*lo, NULL);
+	pull_left_spine(*hi, NULL);
+#endif
+}
+
+
+/*	Join two trees such that every key in *lo is less than or equal to every
+	key in *hi.  The maximum of *lo is splayed to the root, and *hi becomes its
+	right subtree.  Returns the root of the joined tree. */
+static
+struct splay_Node* join_and_splay(struct splay_Node* lo, struct splay_Node* hi)
+{
+	if (NULL == lo)
+		return hi;
+
+	lo = max_and_splay(lo);
+	SPLAY_ASSERT(NULL == lo -> right);
+	lo -> right = hi;
+	node_pull(lo);
+	return lo;
+}
+
+
+/*	Search for key k by top-down splaying, and if it is absent, insert a new
+	node (k, sat) at the place the search ended, all in one descent.  This
+	is search_and_splay and insert_and_splay at once:  if k turns up, that
+	node is splayed to the root; otherwise every node goes to a remainder
+	tree, and the new node, allocated only then, becomes the root.
+
+	Sets *found to 1 if k was present, 0 if a node was inserted, or -1 if
+	the allocation failed, in which case the remainder trees are joined
+	again, so the tree keeps its records.  Returns the new root. */
+static
+struct splay_Node* upsert_and_splay(
+	struct splay_Tree* t,
+	splay_Key k,
+	splay_Satellite sat,
+	int* found
+)
+{
+	struct splay_Topdown td;
+	struct splay_Node *root = t -> root, *n, *lo, *hi;
+
+	*found = 0;
+	for (initialize_topdown(&td); root; topdown_set_aside(&td)) {
+
+		if (LESSKEY(root, k))
+			STEP_RIGHT_FIRST(td, root);
+		else if (KEYLESS(k, root))
+			STEP_LEFT_FIRST(td, root);
+		else {
+			*found = 1;
+			break;
+		}
+
+		if (root) {
+			if (LESSKEY(root, k))
+				STEP_RIGHT_2ND(td, root);
+			else if (KEYLESS(k, root))
+				STEP_LEFT_2ND(td, root);
+			else {
+				/* Found at the child; the final zig is below. */
+				topdown_set_aside(&td);
+				*found = 1;
+				break;
+			}
+		}
+	}
+
+	if (*found)
+		return topdown_assemble(&td, root);
+	if ((n = node_ctor(t, k, sat)) != NULL)
+		return topdown_assemble(&td, n);
+
+	/* Out of memory:  glue the remainder trees back together. */
+	*found = -1;
+	lo = td.rem[0].root;
+	hi = td.rem[1].root;
+#if SPLAY_AUGMENTED
+	pull_right_spine(lo, NULL);
+	pull_left_spine(hi, NULL);
+#endif
+	return join_and_splay(lo, hi);
+}
+
+
+int splay_insert(struct splay_Tree* t, splay_Key k, splay_Satellite sat)
+{
+	struct splay_Node* n = node_ctor(t, k, sat);
+	if (NULL == n)
+		return EXIT_FAILURE;
+
+	t -> root = insert_and_splay(t -> root, n);
+	SPLAY_ASSERT(n == t -> root);
+	t -> size += 1;
+	return EXIT_SUCCESS;
+}
+
+
+/*	Is it cheaper to add a sorted batch of n records to a tree of the given
+	size by merging and rebuilding, in time linear in size + n, than by
+	inserting them one at a time, at about log2(size + n) apiece? */
+static int batch_prefers_merge(unsigned size, unsigned n)
+{
+	unsigned lg = 0, m = size + n;
+
+	while (m >>= 1)
+		lg += 1;
+	return size / (lg + 1) <= n;
+}
+
+
+/** @brief Insert many records at once.
+
+	@param t		Tree to insert into
+	@param keys		Array of n keys, in any order
+	@param sats		Array of n satellite values, or NULL to insert NULLs
+	@param n		Number of records
+
+	The batch is sorted first.  If it is large compared to the tree, it is
+	then merged with the in-order sequence of the tree, and the tree is
+	rebuilt perfectly balanced, in O(size + n) time.  Otherwise the records
+	are inserted one at a time in key order, which keeps each insertion
+	close to the previous one.  Sorting uses memory from the allocator
+	of *t.
+
+	All the nodes are allocated before the tree is touched, so if this
+	fails, the tree is unchanged.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (bad arguments or out of memory). */
+int splay_insert_batch(
+	struct splay_Tree* t,
+	const splay_Key keys[],
+	const splay_Satellite sats[],
+	unsigned n
+)
+{
+	struct batch_Entry* order;
+	struct splay_Node *fresh = NULL, **tail = &fresh, *old, *v, *head,
+		**out = &head;
+	unsigned i, count;
+
+	if (NULL == t || (n > 0 && NULL == keys))
+		return EXIT_FAILURE;
+	if (0 == n)
+		return EXIT_SUCCESS;
+
+	if (NULL == (order = batch_alloc(t, n)))
+		return EXIT_FAILURE;
+	for (i = 0; i < n; ++i) {
+		order[i].key = keys[i];
+		order[i].index = i;
+	}
+	qsort(order, n, sizeof(*order), batch_entry_cmp);
+
+	/* String the new nodes into a vine, in key order. */
+	for (i = 0; i < n; ++i) {
+		if (NULL == (v = node_ctor(t, order[i].key,
+								sats ? sats[order[i].index] : NULL))) {
+			splay_dtor_helper(t, fresh);
+			t -> alloc.release(t -> alloc.context, order);
+			return EXIT_FAILURE;
+		}
+		*tail = v;
+		tail = & v -> right;
+	}
+	t -> alloc.release(t -> alloc.context, order);
+
+	if (batch_prefers_merge(t -> size, n)) {
+		old = tree_to_vine(t -> root, &count);
+		while (fresh && old) {
+			if (LESSKEY(old, fresh -> keiy)) {
+				*out = old;
+				old = old -> right;
+			}
+			else {
+				*out = fresh;
+				fresh = fresh -> right;
+			}
+			out = & (*out) -> right;
+		}
+		*out = fresh ? fresh : old;
+		t -> root = vine_to_tree(&head, count + n);
+	}
+	else
+		while (fresh) {
+			v = fresh;
+			fresh = fresh -> right;
+			v -> right = NULL;
+			t -> root = insert_and_splay(t -> root, v);
+		}
+
+	t -> size += n;
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Update the satellite field of an existing node with key k.
+	@returns EXIT_SUCCESS or EXIT_FAILURE (if k is not found).
+
+	@warning This function is almost never useful in a multimap application.
+	If the tree holds duplicate keys, just one matching record is affected.
+	There is no way to control which of the records with key k is altered.
+
+	@see @ref MAPSEM
+
+	Time complexity: O(log n) for a tree of size n. */
+int splay_update(struct splay_Tree* t, splay_Key k, splay_Satellite sat)
+{
+	int rc = EXIT_FAILURE, found = 0;
+	t -> root = search_and_splay(t -> root, k, & found);
+	if (found) {
+		SPLAY_ASSERT(k == t -> root -> keiy);
+		rc = EXIT_SUCCESS;
+		t -> root -> sat = sat;
+		node_pull(t -> root);
+	}
+	return rc;
+}
+
+
+/*	Support for splay_upsert and splay_insert_unique:  find or insert key k
+	in one pass, replacing the satellite data of a found record if 'replace'
+	is true, and describing the prior record in *prior unless it is NULL. */
+static int upsert_helper(
+	struct splay_Tree* t,
+	splay_Key k,
+	splay_Satellite sat,
+	int replace,
+	struct splay_Result* prior
+)
+{
+	struct splay_Result r = SPLAY_BLANK_RESULT;
+	int found;
+
+	if (NULL == t)
+		return EXIT_FAILURE;
+
+	t -> root = upsert_and_splay(t, k, sat, &found);
+	if (found < 0)
+		return EXIT_FAILURE;
+
+	if (found) {
+		r.found = 1;
+		r.key = t -> root -> keiy;
+		r.sat = t -> root -> sat;
+		if (replace) {
+			t -> root -> sat = sat;
+			node_pull(t -> root);
+		}
+	}
+	else
+		t -> size += 1;
+
+	if (prior)
+		*prior = r;
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Update a record with key k to hold sat, or insert (k, sat).
+
+	@param t			Tree to modify
+	@param k			Key to find or insert
+	@param sat			New satellite data
+	@param[out] prior	Pointer to storage for the previous record, or NULL.
+						Its 'found' field tells whether k was present, and
+						if so, its 'sat' field holds the replaced data.
+
+	Unlike splay_update() followed by splay_insert(), this descends the
+	tree once:  if the search for k fails, the new node is attached where
+	the search ended.  A node is allocated only when one is needed.  As
+	with splay_update(), if several records have key k, just one of them
+	is affected.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (bad arguments or out of memory,
+	in which case the tree keeps all its records).
+
+	Time complexity: O(log n) amortized for a tree of size n. */
+int splay_upsert(
+	struct splay_Tree* t,
+	splay_Key k,
+	splay_Satellite sat,
+	struct splay_Result* prior
+)
+{
+	return upsert_helper(t, k, sat, 1, prior);
+}
+
+
+/** @brief Insert (k, sat) unless the tree already has a record with key k.
+
+	If key k is present, the tree is not changed apart from splaying, and
+	*prior (unless NULL) reports the existing record.  The parameters and
+	return value are otherwise as for splay_upsert().
+	@see splay_upsert() */
+int splay_insert_unique(
+	struct splay_Tree* t,
+	splay_Key k,
+	splay_Satellite sat,
+	struct splay_Result* prior
+)
+{
+	return upsert_helper(t, k, sat, 0, prior);
+}
+
+
+/*	Support for splay_split and splay_join:  make empty tree *t hold the nodes
+	at root, which came from tree *from.  Unless they are the same tree, *t
+	gives up its own allocator and arena, and shares those of *from. */
+static void adopt(
+	struct splay_Tree* t,
+	const struct splay_Tree* from,
+	struct splay_Node* root,
+	unsigned size
+)
+{
+	SPLAY_ASSERT(t && from && NULL == t -> root);
+
+	if (t != from && t -> arena != from -> arena) {
+		splay_tree_dtor(t);
+		t -> alloc = from -> alloc;
+		if (NULL != (t -> arena = from -> arena))
+			t -> arena -> refs += 1;
+	}
+	else if (t != from)
+		t -> alloc = from -> alloc;
+
+	t -> root = root;
+	t -> size = size;
+}
+
+
+#if ! SPLAY_ORDER_STAT
+/*	Support for splay_split without subtree counts:  return the number of
+	records in *plo, where *plo and *phi hold the 'size' records of tree *t.
+	Cursors walk both pieces in step until one runs out, so this takes time
+	proportional to the smaller piece.  If a cursor cannot grow its path,
+	*plo is counted by flattening it to a vine and rebuilding it balanced. */
+static unsigned count_split(
+	const struct splay_Tree* t,
+	struct splay_Node** plo,
+	struct splay_Node* hi,
+	unsigned size
+)
+{
+	struct splay_Tree a = *t, b = *t;	/* supply the allocator for ca, cb */
+	struct splay_Cursor ca, cb;
+	struct splay_Result ra, rb;
+	struct splay_Node* head;
+	unsigned i = 0;
+
+	a.root = *plo;
+	b.root = hi;
+	splay_cursor_ctor(&ca, &a);
+	splay_cursor_ctor(&cb, &b);
+	for (ra = splay_cursor_first(&ca), rb = splay_cursor_first(&cb);
+			ra.found && rb.found;
+			ra = splay_cursor_next(&ca), rb = splay_cursor_next(&cb))
+		++i;
+	splay_cursor_dtor(&ca);
+	splay_cursor_dtor(&cb);
+
+	if (! ca.failed && ! cb.failed)
+		return ra.found ? size - i : i;
+
+	head = tree_to_vine(*plo, &i);
+	*plo = vine_to_tree(&head, i);
+	return i;
+}
+#endif
+
+
+/** @brief Split tree *t into the records with keys less than k, and the rest.
+
+	@param t		Tree to split; it ends up empty unless it is also one of
+					the outputs
+	@param k		Key at which to split
+	@param[out] lo_out	Receives the records with keys less than k
+	@param[out] hi_out	Receives the records with keys k or greater
+
+	@pre Trees *lo_out and *hi_out must be distinct, and each must either be
+	*t itself or an initialized empty tree.
+
+	The outputs take over the allocator of *t, releasing their own.  If *t
+	has a slab arena, the outputs share it (and so does *t); it is released
+	when the last tree sharing it is destroyed.  Trees sharing an arena must
+	not be used by different threads at the same time.
+
+	This splays the boundary, and takes O(log n) amortized time if the
+	library was compiled with macro @ref SPLAY_ORDER_STAT nonzero, since the
+	size of each output is read from the subtree counts.  Otherwise the
+	records of the smaller output are counted, which adds time proportional
+	to its size.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (bad arguments, in which case *t
+	is unchanged). */
+int splay_split(
+	struct splay_Tree* t,
+	splay_Key k,
+	struct splay_Tree* lo_out,
+	struct splay_Tree* hi_out
+)
+{
+	struct splay_Node *lo, *hi;
+	unsigned size, lo_size;
+
+	if (NULL == t || NULL == lo_out || NULL == hi_out || lo_out == hi_out
+			|| (lo_out != t && lo_out -> root)
+			|| (hi_out != t && hi_out -> root))
+		return EXIT_FAILURE;
+
+	split_and_splay(t -> root, k, 0, &lo, &hi);
+	size = t -> size;
+#if SPLAY_ORDER_STAT
+	lo_size = SUBTREE_COUNT(lo);
+#else
+	lo_size = count_split(t, &lo, hi, size);
+#endif
+	t -> root = NULL;
+	t -> size = 0;
+	adopt(lo_out, t, lo, lo_size);
+	adopt(hi_out, t, hi, size - lo_size);
+	return EXIT_SUCCESS;
+}
+
+
+/* Do trees *a and *b get their memory from the same place? */
+static int same_memory(const struct splay_Tree* a, const struct splay_Tree* b)
+{
+	return a -> arena == b -> arena
+		&& a -> alloc.alloc == b -> alloc.alloc
+		&& a -> alloc.release == b -> alloc.release
+		&& a -> alloc.context == b -> alloc.context;
+}
+
+
+/** @brief Join trees *lo and *hi, where no key of *lo exceeds any key of *hi.
+
+	@param lo		Tree with the lesser keys; it ends up empty unless it
+					is also the output
+	@param hi		Tree with the greater keys; likewise
+	@param[out] out	Receives all the records of *lo and *hi
+
+	@pre Trees *lo and *hi must be distinct, and *out must either be one of
+	them or an initialized empty tree.  If both *lo and *hi are nonempty,
+	they must use the same allocator and arena, e.g., because they came
+	from splay_split().  An empty *out takes over their allocator and arena,
+	releasing its own.
+
+	This splays the maximum of *lo and the minimum of *hi, and takes
+	O(log n) amortized time.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (bad arguments, different memory,
+	or overlapping keys, in which case the trees are unchanged apart from
+	splaying). */
+int splay_join(
+	struct splay_Tree* lo,
+	struct splay_Tree* hi,
+	struct splay_Tree* out
+)
+{
+	struct splay_Node* root;
+	const struct splay_Tree* from;
+	unsigned size;
+
+	if (NULL == lo || NULL == hi || NULL == out || lo == hi
+			|| (out != lo && out != hi && out -> root))
+		return EXIT_FAILURE;
+
+	if (lo -> root && hi -> root) {
+		if (! same_memory(lo, hi))
+			return EXIT_FAILURE;
+		lo -> root = max_and_splay(lo -> root);
+		hi -> root = min_and_splay(hi -> root);
+		if (LESSKEY(hi -> root, lo -> root -> keiy))
+			return EXIT_FAILURE;
+		lo -> root -> right = hi -> root;
+		node_pull(lo -> root);
+	}
+	else if (NULL == lo -> root && NULL == hi -> root)
+		return EXIT_SUCCESS;
+
+	from = lo -> root ? lo : hi;
+	root = from -> root;
+	size = lo -> size + hi -> size;
+	lo -> root = hi -> root = NULL;
+	lo -> size = hi -> size = 0;
+	adopt(out, from, root, size);
+	return EXIT_SUCCESS;
+}
+
+
+/*	Support for range_helper:  walk subtree *pmid of tree *t in key order, for
+	at most 'limit' records, copying the first bufsz of them to keys[] and
+	sats[] (when those are not NULL).  Returns the number of records walked.
+
+	The walk keeps its path in a cursor, from the allocator of *t, so the
+	subtree is left as it is.  If the path cannot grow, the subtree is
+	flattened to a vine instead, read without recursion, and rebuilt
+	balanced into *pmid. */
+static
+unsigned range_walk(
+	struct splay_Tree* t,
+	struct splay_Node** pmid,
+	splay_Key keys[],
+	splay_Satellite sats[],
+	unsigned bufsz,
+	unsigned limit
+)
+{
+	struct splay_Tree part = *t;	/* supplies the allocator for c */
+	struct splay_Cursor c;
+	struct splay_Result r;
+	struct splay_Node *head, *v;
+	unsigned count, i = 0;
+
+	part.root = *pmid;
+	splay_cursor_ctor(&c, &part);
+	for (r = splay_cursor_first(&c); r.found && i < limit;
+										r = splay_cursor_next(&c), ++i)
+		if (i < bufsz) {
+			if (keys)
+				keys[i] = r.key;
+			if (sats)
+				sats[i] = r.sat;
+		}
+	splay_cursor_dtor(&c);
+	if (! c.failed)
+		return i;
+
+	head = v = tree_to_vine(*pmid, &count);
+	for (i = 0; i < count && i < limit; ++i, v = v -> right)
+		if (i < bufsz) {
+			if (keys)
+				keys[i] = v -> keiy;
+			if (sats)
+				sats[i] = v -> sat;
+		}
+	*pmid = vine_to_tree(&head, count);
+	return i;
+}
+
+
+/*	Support for the range operations:  find the records with keys in [lo, hi]
+	and copy the first bufsz of them, in order, to keys[] and sats[] (when
+	those are not NULL).  Returns the number of records in the range.
+
+	The boundaries are splayed by splitting the tree into three pieces; the
+	middle piece holds exactly the records in the range, and the pieces are
+	joined again afterwards.  With SPLAY_ORDER_STAT the middle piece knows
+	its size, so counting costs O(log n) amortized, and reading only walks
+	the records it copies.  Otherwise the middle piece is walked in order,
+	in O(log n + k) amortized time for k records. */
+static
+unsigned range_helper(
+	struct splay_Tree* t,
+	splay_Key lo,
+	splay_Key hi,
+	splay_Key keys[],
+	splay_Satellite sats[],
+	unsigned bufsz
+)
+{
+	struct splay_Node *left, *mid, *right;
+	unsigned count;
+
+	SPLAY_ASSERT(t);
+	if (NULL == t -> root || KEY_LT(hi, lo))
+		return 0;
+
+	split_and_splay(t -> root, lo, 0, &left, &mid);
+	split_and_splay(mid, hi, 1, &mid, &right);
+
+#if SPLAY_ORDER_STAT
+	count = SUBTREE_COUNT(mid);
+	if ((keys || sats) && bufsz > 0 && mid)
+		range_walk(t, &mid, keys, sats, bufsz, bufsz);
+#else
+	count = mid ? range_walk(t, &mid, keys, sats, bufsz, UINT_MAX) : 0;
+#endif
+
+	t -> root = join_and_splay(left, join_and_splay(mid, right));
+	return count;
+}
+
+
+/** @brief Count the records with keys in the range [lo, hi].
+
+	The range boundaries are splayed, so this takes O(log n + k) amortized
+	time for k records in the range, or just O(log n) if the library was
+	compiled with macro SPLAY_ORDER_STAT set to a nonzero value.
+	Returns zero if t is NULL or hi < lo. */
+unsigned splay_count_range(struct splay_Tree* t, splay_Key lo, splay_Key hi)
+{
+	return t ? range_helper(t, lo, hi, NULL, NULL, 0) : 0;
+}
+
+
+/** @brief Read the records with keys in the range [lo, hi], in key order.
+
+	@param t		Tree to query (it is splayed)
+	@param lo		Least key in the range
+	@param hi		Greatest key in the range
+	@param[out] keys	Array of size at least bufsz to receive the keys,
+					or NULL if you do not want them.
+	@param[out] sats	Array of size at least bufsz to receive the satellite
+					data, or NULL if you do not want it.
+	@param bufsz	Maximum number of records to write
+
+	This takes O(log n + k) amortized time for k records in the range; but
+	if the library was compiled with macro SPLAY_ORDER_STAT set to a nonzero
+	value, only the records written are walked.
+
+	@returns the number of records in the range, or zero if t is NULL.
+	Like snprintf(), this counts every record in the range, but only the
+	first bufsz are written:  all were written if the result does not
+	exceed bufsz. */
+unsigned splay_read_range(
+	struct splay_Tree* t,
+	splay_Key lo,
+	splay_Key hi,
+	splay_Key keys[],
+	splay_Satellite sats[],
+	unsigned bufsz
+)
+{
+	return t ? range_helper(t, lo, hi, keys, sats, bufsz) : 0;
+}
+
+
+/** @brief Erase all the records with keys in the range [lo, hi].
+
+	@param t		Tree to modify
+	@param lo		Least key in the range
+	@param hi		Greatest key in the range
+	@param visit	Function to call on each erased record, e.g., to release
+					its satellite data, or NULL
+	@param context	Pointer passed unchanged to every call of visit
+
+	The boundaries are splayed to cut the records in the range out of the
+	tree as one subtree, in O(log n) amortized time.  Then the subtree is
+	released node by node without recursion, so the whole operation takes
+	O(log n + k) amortized time for k records.  The records are visited in
+	no particular order, after they have left the tree.
+
+	@returns the number of records erased (zero if t is NULL or hi < lo). */
+unsigned splay_erase_range(
+	struct splay_Tree* t,
+	splay_Key lo,
+	splay_Key hi,
+	splay_Visitor visit,
+	void* context
+)
+{
+	struct splay_Node *left, *mid, *right, *y;
+	unsigned count = 0;
+
+	if (NULL == t || NULL == t -> root || KEY_LT(hi, lo))
+		return 0;
+
+	split_and_splay(t -> root, lo, 0, &left, &mid);
+	split_and_splay(mid, hi, 1, &mid, &right);
+	t -> root = join_and_splay(left, right);
+
+	/* Release the middle tree by rotation, as splay_dtor_helper does. */
+	while (mid)
+		if (mid -> left) {
+			y = mid -> left;
+			mid -> left = y -> right;
+			y -> right = mid;
+			mid = y;
+		}
+		else {
+			y = mid -> right;
+			if (visit)
+				visit(context, mid -> keiy, mid -> sat);
+			FREENODE(t, mid);
+			mid = y;
+			count += 1;
+		}
+
+	t -> size -= count;
+	return count;
+}
+
+
+#if SPLAY_AGGREGATE
+/** @brief Aggregate the records with keys in the closed interval [lo, hi].
+
+	@returns the combination, in key order, of SPLAY_AGG_LIFT applied to
+	each such record, or SPLAY_AGG_IDENTITY if there are none.
+
+	The tree is split at both boundaries, the aggregate is read from the
+	root of the middle piece, and the pieces are joined again, so this
+	takes O(log n) amortized time however many records are in the range.
+
+	This exists only if the library is compiled with macro
+	@ref SPLAY_AGGREGATE nonzero. */
+splay_Aggregate splay_range_aggregate(
+	struct splay_Tree* t,
+	splay_Key lo,
+	splay_Key hi
+)
+{
+	struct splay_Node *left, *mid, *right;
+	splay_Aggregate a;
+
+	if (NULL == t || NULL == t -> root || KEY_LT(hi, lo))
+		return SPLAY_AGG_IDENTITY;
+
+	split_and_splay(t -> root, lo, 0, &left, &mid);
+	split_and_splay(mid, hi, 1, &mid, &right);
+	a = SUBTREE_AGG(mid);
+	t -> root = join_and_splay(left, join_and_splay(mid, right));
+	return a;
+}
+#endif
+
+
+/*	Support for splay_erase_exact and splay_erase_if:  erase the first record
+	with key k, in key order, for which pred returns nonzero.
+
+	The records with key k are split off into a tree of their own, which is
+	flattened to a vine so the match can be unlinked, then rebuilt and joined
+	back.  So the cost is O(log n) amortized, plus O(d) for the d records
+	with key k, and the other records with key k keep their order. */
+static int erase_match_helper(
+	struct splay_Tree* t,
+	splay_Key k,
+	splay_Predicate pred,
+	void* context,
+	splay_Satellite* psat
+)
+{
+	struct splay_Node *left, *mid, *right, *vine, **link, *victim = NULL;
+	unsigned count;
+
+	if (NULL == t || NULL == pred)
+		return EXIT_FAILURE;
+
+	split_and_splay(t -> root, k, 0, &left, &mid);
+	split_and_splay(mid, k, 1, &mid, &right);
+
+	vine = tree_to_vine(mid, &count);
+	for (link = &vine; *link; link = & (*link) -> right)
+		if (pred(context, (*link) -> keiy, (*link) -> sat)) {
+			victim = *link;
+			*link = victim -> right;
+			count -= 1;
+			break;
+		}
+	mid = vine_to_tree(&vine, count);
+	t -> root = join_and_splay(left, join_and_splay(mid, right));
+
+	if (NULL == victim)
+		return EXIT_FAILURE;
+	if (psat)
+		*psat = victim -> sat;
+	FREENODE(t, victim);
+	t -> size -= 1;
+	return EXIT_SUCCESS;
+}
+
+
+/* Predicate for splay_erase_exact:  does sat equal the target? */
+static int same_satellite(void* target, splay_Key k, splay_Satellite sat)
+{
+	(void) k;
+	return * (const splay_Satellite*) target == sat;
+}
+
+
+/** @brief Erase a record with key k and satellite data sat, if there is one.
+
+	In a multimap, splay_erase() removes an arbitrary one of the records with
+	key k; this removes a particular one.  The records with key k are
+	examined in key order, and only they are examined, so for d such records
+	this takes O(log n + d) amortized time.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (if there is no such record). */
+int splay_erase_exact(struct splay_Tree* t, splay_Key k, splay_Satellite sat)
+{
+	return erase_match_helper(t, k, same_satellite, &sat, NULL);
+}
+
+
+/** @brief Erase the first record with key k that satisfies a predicate.
+
+	@param t			Tree to modify
+	@param k			Key of the record to erase
+	@param pred			Function called on the records with key k, in order,
+						until it returns nonzero; it must not modify the tree
+	@param context		Opaque pointer passed to pred
+	@param[out] psat	Pointer to storage for the erased satellite data,
+						or NULL
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (if no record qualifies).
+	@see splay_erase_exact() */
+int splay_erase_if(
+	struct splay_Tree* t,
+	splay_Key k,
+	splay_Predicate pred,
+	void* context,
+	splay_Satellite* psat
+)
+{
+	return erase_match_helper(t, k, pred, context, psat);
+}
+
+
+/** @brief Construct a cursor for tree *t, positioned off the end.
+
+	Call splay_cursor_first(), splay_cursor_last() or splay_cursor_seek()
+	to put it on a record.  The cursor gets memory from the allocator of
+	*t, and keeps it until splay_cursor_dtor() is called.
+
+	@returns EXIT_SUCCESS unless c or t equals NULL.
+
+	@note This is a constructor function. */
+int splay_cursor_ctor(struct splay_Cursor* c, const struct splay_Tree* t)
+{
+	if (NULL == c || NULL == t)
+		return EXIT_FAILURE;
+
+	c -> tree = t;
+	c -> alloc = t -> alloc;
+	c -> path = NULL;
+	c -> depth = c -> cap = 0;
+	c -> failed = 0;
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Destructor for a cursor; safe to call on NULL, or twice. */
+void splay_cursor_dtor(struct splay_Cursor* c)
+{
+	if (c && c -> path) {
+		c -> alloc.release(c -> alloc.context, (void*) c -> path);
+		c -> path = NULL;
+		c -> depth = c -> cap = 0;
+	}
+}
+
+
+/* Append node *n to the path of cursor *c, growing the path if necessary.
+   On failure, the cursor goes off the end, marked as failed. */
+static int cursor_push(struct splay_Cursor* c, const struct splay_Node* n)
+{
+	SPLAY_ASSERT(c && n);
+
+	if (c -> depth == c -> cap) {
+		const struct splay_Allocator* a = & c -> alloc;
+		unsigned i, cap = c -> cap ? 2 * c -> cap : SPLAY_CURSOR_DEPTH;
+		const struct splay_Node** p = (const struct splay_Node**)
+						a -> alloc(a -> context, cap * sizeof(*p));
+		if (NULL == p) {
+			c -> depth = 0;
+			c -> failed = 1;
+			return EXIT_FAILURE;
+		}
+		for (i = 0; i < c -> depth; ++i)
+			p[i] = c -> path[i];
+		if (c -> path)
+			a -> release(a -> context, (void*) c -> path);
+		c -> path = p;
+		c -> cap = cap;
+	}
+
+	c -> path[c -> depth++] = n;
+	return EXIT_SUCCESS;
+}
+
+
+/* Return the record at the current position of cursor *c, if any. */
+static struct splay_Result cursor_result(const struct splay_Cursor* c)
+{
+	struct splay_Result r = SPLAY_BLANK_RESULT;
+
+	if (c && c -> depth) {
+		r.found = 1;
+		r.key = c -> path[c -> depth - 1] -> keiy;
+		r.sat = c -> path[c -> depth - 1] -> sat;
 	}
-	else /* Then *radix has no successor -- so just splice it out. */
-		t -> root = radix -> left;
+	return r;
+}
 
-	/* Unnecessary!
-	radix -> left = radix -> right = NULL;
-	 */
 
-	FREENODE(radix);
+/* Extend the path of cursor *c from node *n down the left links (if 'left')
+   or right links (otherwise) as far as possible, and return the result. */
+static struct splay_Result cursor_descend(
+	struct splay_Cursor* c,
+	const struct splay_Node* n,
+	int left
+)
+{
+	for ( ; n; n = left ? n -> left : n -> right)
+		if (cursor_push(c, n) != EXIT_SUCCESS)
+			break;
+	return cursor_result(c);
+}
+
 
-	t -> size -= 1;
-	return EXIT_SUCCESS;
+/* Move cursor *c one step in key order:  forwards if 'forward' is true,
+   backwards otherwise. */
+static struct splay_Result cursor_step(struct splay_Cursor* c, int forward)
+{
+	const struct splay_Node *n, *next;
+
+	if (NULL == c || 0 == c -> depth)
+		return cursor_result(NULL);
+
+	/* If there is a subtree in the direction of travel, the neighbor is its
+	   extreme node in the opposite direction. */
+	n = c -> path[c -> depth - 1];
+	if (NULL != (next = forward ? n -> right : n -> left))
+		return cursor_descend(c, next, forward);
+
+	/* Otherwise climb until we arrive at an ancestor from the other side,
+	   or run out of ancestors. */
+	do
+		n = c -> path[--c -> depth];
+	while (c -> depth
+		&& n == (forward ? c -> path[c -> depth - 1] -> right
+						 : c -> path[c -> depth - 1] -> left));
+
+	return cursor_result(c);
 }
 
 
-/** @brief Search for the maximum element in the tree (which we splay).
- *
- * If you want to extract the maximum element, just perform an erase on the
- * key you find.
- *
- * @code
- * struct splay_Result r = splay_max(&t);
- * if (r.found)
- *     splay_erase(&t, r.key);
- * @endcode
- */
-struct splay_Result splay_max(struct splay_Tree *t)
+/* Return the node at the current position of cursor *c, or NULL. */
+static const struct splay_Node* cursor_node(const struct splay_Cursor* c)
 {
-	struct splay_Result r = SPLAY_BLANK_RESULT;
+	return c -> depth ? c -> path[c -> depth - 1] : NULL;
+}
 
-	if (NULL == t || NULL == t -> root)
-		r.found = 0;
-	else {
-		struct splay_Node* root = t -> root;
-		struct splay_Topdown td;
-		SPLAY_ASSERT(root);
 
-		/* See the comments for splay_min for a complete exegesis.
-		 * We walk down the chain of rightward links and store everything
-		 * in the left remainder tree.
-		 */
-		for (initialize_topdown(&td); root -> right; topdown_set_aside(&td)) {
-			STEP_RIGHT_FIRST(td, root);
-			if (root -> right)
-				STEP_RIGHT_2ND(td, root);
-		}
+/* Start a preorder walk of the tree of cursor *c, and return its root.
+   During the walk, the parent of the current node is one below the top
+   of the cursor path. */
+static const struct splay_Node* preorder_first(struct splay_Cursor* c)
+{
+	c -> depth = 0;
+	c -> failed = 0;
+	if (c -> tree -> root)
+		cursor_push(c, c -> tree -> root);
+	return cursor_node(c);
+}
 
-		SPLAY_ASSERT(root && NULL == root -> right);
 
-		* td.rem[0].tip = root -> left;
-		root -> left = td.rem[0].root;
-		t -> root = root;
+/* Advance cursor *c to the next node in preorder, and return it (or NULL
+   at the end of the walk or if the path cannot grow). */
+static const struct splay_Node* preorder_next(struct splay_Cursor* c)
+{
+	const struct splay_Node *n = cursor_node(c), *p;
 
-		/* Don't bother with the right remainder tree because it is empty. */
-		SPLAY_ASSERT(NULL == td.rem[1].root);
+	if (NULL == n)
+		return NULL;
 
-		r.found = 1;
-		r.key = root -> keiy;
-		r.sat = root -> sat;
+	if (n -> left || n -> right) {
+		cursor_push(c, n -> left ? n -> left : n -> right);
+		return cursor_node(c);
 	}
 
-	return r;
+	/* Climb until we leave a left subtree whose parent has a right child. */
+	for (--c -> depth; c -> depth; --c -> depth) {
+		p = c -> path[c -> depth - 1];
+		if (n == p -> left && p -> right) {
+			cursor_push(c, p -> right);
+			return cursor_node(c);
+		}
+		n = p;
+	}
+	return NULL;
 }
 
 
-/* Test whether a node is a leaf in a BST sense. */
-static int is_bst_leaf(const struct splay_Node* n)
+/** @brief Move the cursor to the first record of the tree (if any). */
+struct splay_Result splay_cursor_first(struct splay_Cursor* c)
 {
-	return n && NULL == n -> left && NULL == n -> right;
+	if (NULL == c)
+		return cursor_result(NULL);
+
+	c -> depth = 0;
+	c -> failed = 0;
+	return cursor_descend(c, c -> tree -> root, 1);
 }
 
 
-/* This is also a simple kind of splaying -- we just rip the tree in half
- * according to the new node's key, until root becomes null.  Then glue
- * the remainder trees onto n. */
-static
-struct splay_Node* insert_and_splay(
-	struct splay_Node* root,
-	struct splay_Node* n
-)
+/** @brief Move the cursor to the last record of the tree (if any). */
+struct splay_Result splay_cursor_last(struct splay_Cursor* c)
 {
-	/* Storage for state during top-down splaying. */
-	struct splay_Topdown td;
+	if (NULL == c)
+		return cursor_result(NULL);
 
-	/* Special case for simplicity. */
-	if (NULL == root)
-		return n;
+	c -> depth = 0;
+	c -> failed = 0;
+	return cursor_descend(c, c -> tree -> root, 0);
+}
 
-	/* Partition ALL old nodes into the left and right remainder trees. */
-	for (initialize_topdown(&td); root; topdown_set_aside(&td)) {
 
-		SPLAY_ASSERT(root);
+/** @brief Move the cursor to the next record in key order (if any).
 
-		if (LESSKEY(root, n -> keiy))
-			STEP_RIGHT_FIRST(td, root);
-		else
-			STEP_LEFT_FIRST(td, root);
+	Amortized constant time, i.e., a full traversal takes linear time.
+	A single step might take time proportional to the height of the tree. */
+struct splay_Result splay_cursor_next(struct splay_Cursor* c)
+{
+	return cursor_step(c, 1);
+}
 
-		if (root) {
-			if (LESSKEY(root, n -> keiy))
-				STEP_RIGHT_2ND(td, root);
-			else
-				STEP_LEFT_2ND(td, root);
-		}
-	}
 
-	/* Graft the remainder trees onto the new node n -- hail the new root! */
-	SPLAY_ASSERT(is_bst_leaf(n));
-	n -> left = td.rem[0].root;
-	n -> right = td.rem[1].root;
-	return n;
+/** @brief Move the cursor to the previous record in key order (if any).
+	@see splay_cursor_next() */
+struct splay_Result splay_cursor_prev(struct splay_Cursor* c)
+{
+	return cursor_step(c, 0);
 }
 
 
-int splay_insert(struct splay_Tree* t, splay_Key k, splay_Satellite sat)
+/** @brief Move the cursor to the first record with key not less than k.
+
+	If there is no such record, the cursor goes off the end.
+	This takes time proportional to the depth of the search path,
+	and it does not splay. */
+struct splay_Result splay_cursor_seek(struct splay_Cursor* c, splay_Key k)
 {
-	struct splay_Node* n = node_ctor(k, sat);
-	if (NULL == n)
-		return EXIT_FAILURE;
+	const struct splay_Node *n;
+	unsigned found = 0; /* path length down to the best candidate so far */
+
+	if (NULL == c)
+		return cursor_result(NULL);
+
+	c -> depth = 0;
+	c -> failed = 0;
+	for (n = c -> tree -> root; n; )
+		if (cursor_push(c, n) != EXIT_SUCCESS)
+			return cursor_result(c);
+		else if (LESSKEY(n, k))
+			n = n -> right;
+		else {
+			found = c -> depth;
+			n = n -> left;
+		}
 
-	t -> root = insert_and_splay(t -> root, n);
-	SPLAY_ASSERT(n == t -> root);
-	t -> size += 1;
-	return EXIT_SUCCESS;
+	c -> depth = found;
+	return cursor_result(c);
 }
 
 
-/** @brief Update the satellite field of an existing node with key k.
-	@returns EXIT_SUCCESS or EXIT_FAILURE (if k is not found).
+/* Support for splay_health_check:  report that a traversal of the tree ran
+   out of memory, as a boolean value like the checks below. */
+static int traversal_failure(char *buf, unsigned bufsize)
+{
+#if SPLAY_HAS_DOT_OUTPUT
+	if (buf)
+		snprintf(buf, bufsize, "Unable to allocate a path to traverse the "
+						"tree; it could not be checked.");
+#else
+	(void) buf;
+	(void) bufsize;
+#endif
+	return 1;
+}
 
-	@warning This function is almost never useful in a multimap application.
-	If the tree holds duplicate keys, just one matching record is affected.
-	There is no way to control which of the records with key k is altered.
 
-	@see @ref MAPSEM
+/* Support for splay_health_check:  is the BST property satisfied in tree *t?
+   Return a boolean value.  If not, print an error message.
 
-	Time complexity: O(log n) for a tree of size n. */
-int splay_update(struct splay_Tree* t, splay_Key k, splay_Satellite sat)
+   The property holds if and only if an in-order walk sees keys in
+   nondecreasing order, which is what we check. */
+static
+int breaks_bst_property(const struct splay_Tree* t, char *buf, unsigned bufsize)
 {
-	int rc = EXIT_FAILURE, found = 0;
-	t -> root = search_and_splay(t -> root, k, & found);
-	if (found) {
-		SPLAY_ASSERT(k == t -> root -> keiy);
-		rc = EXIT_SUCCESS;
-		t -> root -> sat = sat;
+	struct splay_Cursor c;
+	const struct splay_Node *n, *prev = NULL;
+	int broken = 0;
+
+	splay_cursor_ctor(&c, t);
+	for (splay_cursor_first(&c); ! broken && NULL != (n = cursor_node(&c));
+												splay_cursor_next(&c)) {
+		if (prev && LESSKEY(n, prev -> keiy)) {
+#if SPLAY_HAS_DOT_OUTPUT
+			if (buf)
+				snprintf(buf, bufsize, "Node with key %d violates the "
+							"BST property; it follows key %d in order.",
+							n -> keiy, prev -> keiy);
+#endif
+			broken = 1;
+		}
+		prev = n;
 	}
-	return rc;
+
+	if (! broken && c.failed)
+		broken = traversal_failure(buf, bufsize);
+	splay_cursor_dtor(&c);
+	return broken;
 }
 
 
-/* Support for splay_health_check:  is the BST property satisfied in a subtree
-   rooted at *t?  Return a boolean value.  If not, print an error message. */
+#if SPLAY_AUGMENTED
+/* Support for splay_health_check:  are the augmented fields of node *t
+   consistent with its children?  Return a boolean value.  If not, print an
+   error message. */
 static
-int breaks_bst_property(
+int breaks_node_augmentation(
 	const struct splay_Node* t,
-	splay_Key minkey,
-	splay_Key maxkey,
 	char *buf,
 	unsigned bufsize
 )
 {
-	if (NULL == t)
-		return 0;
-	if (LESSKEY(t, minkey) || KEYLESS(maxkey, t)) {
+	SPLAY_ASSERT(t);
+#if ! SPLAY_HAS_DOT_OUTPUT
+	(void) buf;
+	(void) bufsize;
+#endif
+
+#if SPLAY_ORDER_STAT
+	if (t -> count != 1 + SUBTREE_COUNT(t -> left) + SUBTREE_COUNT(t -> right)){
+#if SPLAY_HAS_DOT_OUTPUT
+		if (buf)
+			snprintf(buf, bufsize, "Node with key %d has count %u but its "
+							"subtree has %u nodes.", t -> keiy, t -> count,
+							1 + SUBTREE_COUNT(t -> left)
+							+ SUBTREE_COUNT(t -> right));
+#endif
+		return 1;
+	}
+#endif
+
+#if SPLAY_INTERVAL
+	if (KEY_LT(t -> hi, t -> keiy) || t -> maxhi != NODE_MAXHI(t)) {
+#if SPLAY_HAS_DOT_OUTPUT
+		if (buf)
+			snprintf(buf, bufsize, "Node with interval [%d, %d] has maximum "
+							"right endpoint %d, but its subtree has %d.",
+							t -> keiy, t -> hi, t -> maxhi, NODE_MAXHI(t));
+#endif
+		return 1;
+	}
+#endif
+
+#if SPLAY_AGGREGATE
+	if (! SPLAY_AGG_EQUAL(t -> agg, NODE_AGG(t))) {
 #if SPLAY_HAS_DOT_OUTPUT
 		if (buf)
-			snprintf(buf, bufsize, "Node with key %d violates the "
-							"BST property; should be in range [%d, %d].",
-							t -> keiy, minkey, maxkey);
+			snprintf(buf, bufsize, "Node with key %d has an aggregate that "
+							"disagrees with its subtree.", t -> keiy);
 #endif
 		return 1;
 	}
-	return
-		breaks_bst_property(t-> left, minkey, t -> keiy, buf, bufsize)
-		|| breaks_bst_property(t-> right, t -> keiy, maxkey, buf, bufsize);
+#endif
+
+	return 0;
+}
+
+
+/* Support for splay_health_check:  are the augmented fields of every node in
+   tree *t consistent?  Return a boolean value.  If not, print an error
+   message. */
+static
+int breaks_augmentation(const struct splay_Tree* t, char *buf, unsigned bufsize)
+{
+	struct splay_Cursor c;
+	const struct splay_Node *n;
+	int broken = 0;
+
+	splay_cursor_ctor(&c, t);
+	for (splay_cursor_first(&c); ! broken && NULL != (n = cursor_node(&c));
+												splay_cursor_next(&c))
+		broken = breaks_node_augmentation(n, buf, bufsize);
+
+	if (! broken && c.failed)
+		broken = traversal_failure(buf, bufsize);
+	splay_cursor_dtor(&c);
+	return broken;
 }
+#endif
 
 
 /* Count tree size, return the answer -- linear time!
@@ -1273,11 +3579,21 @@ int breaks_bst_property(
 
    This will loop infinitely if the nodes have directed cycles, and will give
    the wrong answer if there any are unreachable nodes, parallel arcs, or
-   the pointers don't have a valid tree topology. */
+   the pointers don't have a valid tree topology.  If the traversal runs out
+   of memory, *failed is set to a true value. */
 static
-unsigned splay_nodecount(const struct splay_Node* t)
+unsigned splay_nodecount(const struct splay_Tree* t, int* failed)
 {
-	return t ? 1 +splay_nodecount(t -> left) +splay_nodecount(t -> right) : 0;
+	struct splay_Cursor c;
+	unsigned count = 0;
+
+	splay_cursor_ctor(&c, t);
+	for (splay_cursor_first(&c); cursor_node(&c); splay_cursor_next(&c))
+		count += 1;
+
+	*failed = c.failed;
+	splay_cursor_dtor(&c);
+	return count;
 }
 
 
@@ -1287,6 +3603,9 @@ unsigned splay_nodecount(const struct splay_Node* t)
 static
 int splay_size_failure(const struct splay_Tree* t, char* buf, unsigned bufsize)
 {
+	unsigned count;
+	int failed;
+
 	SPLAY_ASSERT(t);
 	if (t -> root && 0 == t -> size) {
 #if SPLAY_HAS_DOT_OUTPUT
@@ -1306,12 +3625,16 @@ int splay_size_failure(const struct splay_Tree* t, char* buf, unsigned bufsize)
 		return 1;
 	}
 
-	if (t -> size != splay_nodecount(t -> root)) {
+	count = splay_nodecount(t, &failed);
+	if (failed)
+		return traversal_failure(buf, bufsize);
+
+	if (t -> size != count) {
 #if SPLAY_HAS_DOT_OUTPUT
 		if (buf)
 			snprintf(buf, bufsize,
 				"Size counter is %u but tree has %u reachable nodes.",
-				t -> size, splay_nodecount(t -> root));
+				t -> size, count);
 #endif
 		return 1;
 	}
@@ -1363,39 +3686,70 @@ int splay_health_check(const struct splay_Tree *t, char buf[], unsigned bufsz)
 		return EXIT_FAILURE;
 
 	/* Check keys */
-	if (breaks_bst_property(t -> root, INT_MIN, INT_MAX, buf, bufsz))
+	if (breaks_bst_property(t, buf, bufsz))
 		return EXIT_FAILURE;
 
+#if SPLAY_AUGMENTED
+	/* Check subtree counts, etc. */
+	if (breaks_augmentation(t, buf, bufsz))
+		return EXIT_FAILURE;
+#endif
+
 	return EXIT_SUCCESS; /* We lack evidence of any problem.  :-|  */
 }
 
 
-/*	This does a postorder deep copy. */
-static int copy_helper(const struct splay_Node* ni, struct splay_Node** no)
+/*	Deep copy of tree *ti into the empty tree *to, using the allocator of *to,
+	in the same shape.  A preorder walk of *ti keeps the ancestors of the
+	current node in a cursor path; a second cursor path, over *to, keeps
+	their clones, so each clone is linked under its parent's clone as soon
+	as it is made.  Both paths grow only to the height of *ti.  The clones
+	are nodes of *to, so the casts that link them are sound. */
+static int copy_helper(const struct splay_Tree* ti, struct splay_Tree* to)
 {
-	SPLAY_ASSERT(no);
+	struct splay_Cursor c, clones;
+	const struct splay_Node *ni;
+	struct splay_Node *no, *parent, *root = NULL;
+	int rc = EXIT_SUCCESS;
+
+	SPLAY_ASSERT(ti && to && NULL == to -> root);
+
+	splay_cursor_ctor(&c, ti);
+	splay_cursor_ctor(&clones, to);
+	for (ni = preorder_first(&c); ni; ni = preorder_next(&c)) {
+		if (NULL == (no = node_ctor(to, ni -> keiy, ni -> sat))) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+		*no = *ni;	/* the augmented fields are right for the same shape */
+		no -> left = no -> right = NULL;
 
-	if (NULL == ni)
-		*no = NULL;
-	else {
-		struct splay_Node *l, *r;
-		if (copy_helper(ni -> left, &l) == EXIT_FAILURE)
-			return EXIT_FAILURE;
-		if (copy_helper(ni -> right, &r) == EXIT_FAILURE) {
-			/* release memory in l */
-			splay_dtor_helper(l);
-			return EXIT_FAILURE;
+		clones.depth = c.depth - 1;
+		if (0 == clones.depth)
+			root = no;
+		else {
+			parent = (struct splay_Node*) cursor_node(&clones);
+			if (c.path[c.depth - 2] -> left == ni)
+				parent -> left = no;
+			else
+				parent -> right = no;
 		}
-		if (NULL == (*no = node_ctor(ni -> keiy, ni -> sat))) {
-			/* release memory already allocated */
-			splay_dtor_helper(l);
-			splay_dtor_helper(r);
-			return EXIT_FAILURE;
+		if (cursor_push(&clones, no) != EXIT_SUCCESS) {
+			rc = EXIT_FAILURE;
+			break;
 		}
-		SPLAY_ASSERT(*no);
-		(*no) -> left = l;
-		(*no) -> right = r;
 	}
+	if (c.failed)
+		rc = EXIT_FAILURE;
+	splay_cursor_dtor(&c);
+	splay_cursor_dtor(&clones);
+
+	if (EXIT_FAILURE == rc) {
+		splay_dtor_helper(to, root);	/* release the partial copy */
+		return EXIT_FAILURE;
+	}
+
+	to -> root = root;
 	return EXIT_SUCCESS;
 }
 
@@ -1404,7 +3758,10 @@ static int copy_helper(const struct splay_Node* ni, struct splay_Node** no)
 
 	@pre Tree *to must be empty.  (Call splay_tree_clear() if not.)
 
-	Tree *ti is unaffected by the operation.
+	Tree *ti is unaffected by the operation:  the copy has the same records
+	in the same shape.  Neither tree is traversed recursively, so this is
+	safe even if *ti has degenerated into a long chain; the walk keeps two
+	paths, as long as the height of *ti, from the trees' allocators.
 
 	@warning
 	This is not a constructor:  output tree *to must be initialized and in an
@@ -1419,9 +3776,337 @@ int splay_tree_copy(const struct splay_Tree* ti, struct splay_Tree* to)
 		return EXIT_FAILURE;
 
 	SPLAY_ASSERT(0 == to -> size);
+	if (copy_helper(ti, to) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+
 	to -> size = ti -> size;
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Insert the interval [lo, hi] as a record, with satellite data sat.
+
+	The interval's left endpoint serves as its key, so the ordinary
+	functions see it as a record with key lo.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (bad arguments, including hi < lo,
+	or out of memory, or the library was compiled without macro
+	@ref SPLAY_INTERVAL). */
+int splay_interval_insert(
+	struct splay_Tree* t,
+	splay_Key lo,
+	splay_Key hi,
+	splay_Satellite sat
+)
+{
+#if SPLAY_INTERVAL
+	struct splay_Node* n;
+
+	if (NULL == t || KEY_LT(hi, lo) || NULL == (n = node_ctor(t, lo, sat)))
+		return EXIT_FAILURE;
+
+	n -> hi = hi;
+	node_pull(n);
+	t -> root = insert_and_splay(t -> root, n);
+	t -> size += 1;
+	return EXIT_SUCCESS;
+#else
+	(void) t;
+	(void) lo;
+	(void) hi;
+	(void) sat;
+	return EXIT_FAILURE;
+#endif
+}
+
+
+/** @brief Report every interval record that overlaps [lo, hi].
+
+	@param t		Tree to search
+	@param lo		Left endpoint of the query; use lo == hi for a point
+	@param hi		Right endpoint of the query
+	@param visit	Function called on each overlapping record, in key order,
+					or NULL; it must not modify the tree
+	@param context	Opaque pointer passed to visit
+
+	The tree is split after the last interval starting at or before hi.
+	The left piece is walked in order, skipping every subtree whose greatest
+	right endpoint lies before lo.  Then the pieces are joined again, which
+	leaves the queried region near the root for the next query.  The walk
+	keeps its path in memory from the allocator of *t.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (bad arguments, or out of memory,
+	in which case some overlaps may go unreported, or the library was
+	compiled without macro @ref SPLAY_INTERVAL). */
+int splay_interval_overlap(
+	struct splay_Tree* t,
+	splay_Key lo,
+	splay_Key hi,
+	splay_IntervalVisitor visit,
+	void* context
+)
+{
+#if SPLAY_INTERVAL
+	struct splay_Cursor stack;
+	struct splay_Node *left, *right;
+	const struct splay_Node* n;
+	int rc;
+
+	if (NULL == t || KEY_LT(hi, lo))
+		return EXIT_FAILURE;
+	if (NULL == t -> root)
+		return EXIT_SUCCESS;
+
+	/* Only intervals starting at or before hi can overlap [lo, hi]. */
+	split_and_splay(t -> root, hi, 1, &left, &right);
+
+	/* In-order walk with an explicit stack, pruned by maxhi.  If the stack
+	   cannot grow, cursor_push empties it, which ends the walk. */
+	splay_cursor_ctor(&stack, t);
+	for (n = left; ; n = n -> right) {
+		while (n && ! KEY_LT(n -> maxhi, lo)
+				&& cursor_push(&stack, n) == EXIT_SUCCESS)
+			n = n -> left;
+		if (0 == stack.depth)
+			break;
+		n = stack.path[--stack.depth];
+		if (! KEY_LT(n -> hi, lo) && visit)
+			visit(context, n -> keiy, n -> hi, n -> sat);
+	}
+	rc = stack.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+	splay_cursor_dtor(&stack);
+
+	t -> root = join_and_splay(left, right);
+	return rc;
+#else
+	(void) t;
+	(void) lo;
+	(void) hi;
+	(void) visit;
+	(void) context;
+	return EXIT_FAILURE;
+#endif
+}
+
+
+/** Kinds of set operation, for set_op_helper. */
+enum set_Op { SET_UNION, SET_INTERSECTION, SET_DIFFERENCE };
+
+
+/*	Support for the set operations:  given na records with some key in the
+	first tree and nb with that key in the second, decide how many of each
+	go into the result, per operation op and policy p. */
+static void set_op_quota(
+	enum set_Op op,
+	enum splay_Policy p,
+	unsigned na,
+	unsigned nb,
+	unsigned* qa,
+	unsigned* qb
+)
+{
+	*qa = *qb = 0;
+	switch (op) {
+		case SET_UNION:
+			*qa = SPLAY_DISTINCT == p && na > 1 ? 1 : na;
+			if (SPLAY_ALL == p)
+				*qb = nb;
+			else if (nb > na)
+				*qb = SPLAY_DISTINCT == p ? (0 == na) : nb - na;
+			break;
+		case SET_INTERSECTION:
+			if (na && nb) {
+				*qa = SPLAY_DISTINCT == p ? 1 : SPLAY_ALL == p || na < nb
+						? na : nb;
+				*qb = SPLAY_ALL == p ? nb : 0;
+			}
+			break;
+		case SET_DIFFERENCE:
+			if (SPLAY_MULTISET == p)
+				*qa = na > nb ? na - nb : 0;
+			else if (0 == nb)
+				*qa = SPLAY_DISTINCT == p && na > 1 ? 1 : na;
+			break;
+	}
+}
+
+
+/*	Support for the set operations:  make room in empty tree *out for
+	exactly n nodes, in one block.  If *out lacks a slab arena, it gets one;
+	if it has one of its own, its old chunks (which hold no live nodes,
+	since the tree is empty) are released first. */
+static int set_op_reserve(struct splay_Tree* out, unsigned n)
+{
+	SPLAY_ASSERT(out && NULL == out -> root && n > 0);
+
+	if (NULL == out -> arena) {
+		if (arena_ctor(out, SPLAY_SLAB_CHUNK) != EXIT_SUCCESS)
+			return EXIT_FAILURE;
+	}
+	else if (1 == out -> arena -> refs)
+		arena_clear(out);
+	return arena_grow(out, n);
+}
+
+
+/*	Support for the set operations:  build in empty tree *out the result of
+	operation op on trees *a and *b, under policy p.
+
+	Each input is walked by two cursors in step:  a leading cursor counts
+	the records with the next key, and a trailing cursor then passes over
+	them again, copying the chosen ones onto a vine, which becomes a
+	balanced tree at the end.  Beforehand, a pass of the leading cursors
+	alone counts the result, so that exactly enough nodes can be reserved
+	in one block.  So each input is traversed three times. */
+static int set_op_helper(
+	const struct splay_Tree* a,
+	const struct splay_Tree* b,
+	struct splay_Tree* out,
+	enum set_Op op,
+	enum splay_Policy p
+)
+{
+	struct splay_Cursor lead_a, lead_b, trail_a, trail_b;
+	struct splay_Result la, lb;
+	struct splay_Node *head = NULL, **tail = &head, *n;
+	unsigned na, nb, qa, qb, i, pass, total = 0, count = 0;
+	splay_Key k;
+	int rc = EXIT_SUCCESS;
+
+	if (NULL == a || NULL == b || NULL == out || NULL != out -> root
+			|| out == a || out == b)
+		return EXIT_FAILURE;
+
+	splay_cursor_ctor(&lead_a, a);
+	splay_cursor_ctor(&trail_a, a);
+	splay_cursor_ctor(&lead_b, b);
+	splay_cursor_ctor(&trail_b, b);
+
+	/* Pass 0 counts the result; pass 1 builds it. */
+	for (pass = 0; pass < 2 && EXIT_SUCCESS == rc; ++pass) {
+		la = splay_cursor_first(&lead_a);
+		lb = splay_cursor_first(&lead_b);
+		if (1 == pass) {
+			if (lead_a.failed || lead_b.failed || 0 == total
+					|| set_op_reserve(out, total) != EXIT_SUCCESS)
+				break;
+			splay_cursor_first(&trail_a);
+			splay_cursor_first(&trail_b);
+		}
+
+		while (EXIT_SUCCESS == rc && (la.found || lb.found)) {
+			k = la.found && (! lb.found || ! KEY_LT(lb.key, la.key))
+				? la.key : lb.key;
+
+			for (na = 0; la.found && ! KEY_LT(k, la.key); ++na)
+				la = splay_cursor_next(&lead_a);
+			for (nb = 0; lb.found && ! KEY_LT(k, lb.key); ++nb)
+				lb = splay_cursor_next(&lead_b);
+			set_op_quota(op, p, na, nb, &qa, &qb);
+
+			if (0 == pass) {
+				total += qa + qb;
+				continue;
+			}
+
+			for (i = 0; i < na + nb; ++i) {
+				struct splay_Cursor* trail = i < na ? &trail_a : &trail_b;
+				if ((i < na ? i < qa : i - na < qb) && EXIT_SUCCESS == rc) {
+					if (NULL == (n = node_clone(out, cursor_node(trail))))
+						rc = EXIT_FAILURE;
+					else {
+						*tail = n;
+						tail = & n -> right;
+						count += 1;
+					}
+				}
+				splay_cursor_next(trail);
+			}
+		}
+	}
+
+	if (lead_a.failed || lead_b.failed || trail_a.failed || trail_b.failed
+			|| count != total)
+		rc = EXIT_FAILURE;
+	splay_cursor_dtor(&lead_a);
+	splay_cursor_dtor(&trail_a);
+	splay_cursor_dtor(&lead_b);
+	splay_cursor_dtor(&trail_b);
+
+	if (EXIT_FAILURE == rc) {
+		splay_dtor_helper(out, head);
+		return EXIT_FAILURE;
+	}
+
+	out -> root = vine_to_tree(&head, count);
+	out -> size = count;
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Build in *out the union of trees *a and *b.
+
+	@param a		First input tree; it is not changed
+	@param b		Second input tree; it is not changed
+	@param[out] out	Initialized empty tree, distinct from *a and *b, which
+					receives copies of the records of the result
+	@param p		Treatment of duplicate keys.  If key k appears in na
+					records of *a and nb records of *b, the result gets
+					one record (SPLAY_DISTINCT), max(na, nb) records
+					(SPLAY_MULTISET) or na + nb records (SPLAY_ALL).
+
+	Records come from *a in preference to *b.  Both inputs are walked in
+	order without splaying, so this takes O(n + m) time, and the result
+	is built perfectly balanced.  The result is counted first, and its
+	nodes are allocated together in one block of exactly that size, from
+	a slab arena of *out.  If *out lacks an arena, it gets one (see
+	splay_tree_slab_ctor()), using the allocator of *out.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (bad arguments or out of memory,
+	in which case *out is still empty). */
+int splay_tree_union(
+	const struct splay_Tree* a,
+	const struct splay_Tree* b,
+	struct splay_Tree* out,
+	enum splay_Policy p
+)
+{
+	return set_op_helper(a, b, out, SET_UNION, p);
+}
+
+
+/** @brief Build in *out the intersection of trees *a and *b.
+
+	Like splay_tree_union(), but for a key in both trees, the result gets
+	one record (SPLAY_DISTINCT), min(na, nb) records (SPLAY_MULTISET) or
+	na + nb records (SPLAY_ALL).
+	@see splay_tree_union() */
+int splay_tree_intersection(
+	const struct splay_Tree* a,
+	const struct splay_Tree* b,
+	struct splay_Tree* out,
+	enum splay_Policy p
+)
+{
+	return set_op_helper(a, b, out, SET_INTERSECTION, p);
+}
 
-	return copy_helper(ti -> root, & to -> root);
+
+/** @brief Build in *out the records of *a whose keys are not in *b.
+
+	Like splay_tree_union(), but the result gets, for a key of *a, one
+	record if the key is absent from *b (SPLAY_DISTINCT), max(0, na - nb)
+	records (SPLAY_MULTISET), or all na records if the key is absent
+	from *b (SPLAY_ALL).
+	@see splay_tree_union() */
+int splay_tree_difference(
+	const struct splay_Tree* a,
+	const struct splay_Tree* b,
+	struct splay_Tree* out,
+	enum splay_Policy p
+)
+{
+	return set_op_helper(a, b, out, SET_DIFFERENCE, p);
 }
 
 
@@ -1438,12 +4123,26 @@ int splay_tree_copy(const struct splay_Tree* ti, struct splay_Tree* to)
 
 	@post Tree *ti is in an empty state when this finishes successfully.
 
+	The two trees also exchange their allocators and slab arenas (if any),
+	since the nodes must stay with the allocator they came from.
+
 	@returns EXIT_SUCCESS or EXIT_FAILURE. */
 int splay_tree_move(struct splay_Tree* ti, struct splay_Tree* to)
 {
+	struct splay_Arena* a;
+	struct splay_Allocator m;
+
 	if (!ti || !to || to -> root != NULL)
 		return EXIT_FAILURE;
 
+	a = to -> arena;
+	to -> arena = ti -> arena;
+	ti -> arena = a;
+
+	m = to -> alloc;
+	to -> alloc = ti -> alloc;
+	ti -> alloc = m;
+
 	SPLAY_ASSERT(0 == to -> size);
 	to -> size = ti -> size;
 	ti -> size = 0;
@@ -9,6 +9,7 @@
 #ifndef PREDOEHL_SPLAY_H_2018_INCLUDED_
 #define PREDOEHL_SPLAY_H_2018_INCLUDED_ 1
 
+#include <stddef.h> /* for size_t */
 
 /** Key type used for the tree.  This type must be in a total order. */
 typedef int splay_Key;
@@ -16,6 +17,37 @@ typedef int splay_Key;
 /** Satellite data type for each record. */
 typedef void* splay_Satellite;
 
+#ifndef SPLAY_AGGREGATE
+/**	@brief Macro to control the aggregate augmentation.
+
+	If this is set to a nonzero value at compile time, via flag
+	-DSPLAY_AGGREGATE=1, then every node stores the aggregate of the records
+	in its subtree under a monoid, and splay_range_aggregate() reports the
+	aggregate of a key range in logarithmic amortized time.  The library and
+	its users must be compiled with the same setting.
+
+	By default the monoid is addition of satellite values cast to long, for
+	trees whose satellite fields hold integers.  To use another, define all
+	of SPLAY_AGG_TYPE (the aggregate type), SPLAY_AGG_IDENTITY (its identity
+	element), SPLAY_AGG_LIFT(k, sat) (the aggregate of one record),
+	SPLAY_AGG_COMBINE(a, b) (an associative operation, applied in key order)
+	and SPLAY_AGG_EQUAL(a, b) (used by splay_health_check()). */
+#define SPLAY_AGGREGATE 0
+#endif
+
+#if SPLAY_AGGREGATE
+#ifndef SPLAY_AGG_TYPE
+#define SPLAY_AGG_TYPE				long
+#define SPLAY_AGG_IDENTITY			0L
+#define SPLAY_AGG_LIFT(k, sat)		((long) (size_t) (sat))
+#define SPLAY_AGG_COMBINE(a, b)		((a) + (b))
+#define SPLAY_AGG_EQUAL(a, b)		((a) == (b))
+#endif
+
+/** Aggregate of a set of records, if SPLAY_AGGREGATE is nonzero. */
+typedef SPLAY_AGG_TYPE splay_Aggregate;
+#endif
+
 /** @brief Output of a search */
 struct splay_Result
 {
@@ -24,7 +56,50 @@ struct splay_Result
 	splay_Satellite sat;	/**< copy of the satellite data of the record */
 };
 
+/** @brief Function called on records, e.g., by splay_erase_range().
+
+	The context pointer is whatever the caller of that function supplied. */
+typedef void (*splay_Visitor)(void* context, splay_Key k, splay_Satellite sat);
+
+/** @brief Function called on interval records by splay_interval_overlap().
+
+	The record is the interval [lo, hi] with satellite data sat. */
+typedef void (*splay_IntervalVisitor)(void* context, splay_Key lo,
+										splay_Key hi, splay_Satellite sat);
+
+/** @brief Test applied to records, e.g., by splay_erase_if().
+
+	It returns nonzero if the record qualifies. */
+typedef int (*splay_Predicate)(void* context, splay_Key k, splay_Satellite sat);
+
+/** @brief Treatment of duplicate keys by the set operations */
+enum splay_Policy
+{
+	SPLAY_DISTINCT,	/**< at most one record per key in the result */
+	SPLAY_MULTISET,	/**< records counted with multiplicity, as in a bag */
+	SPLAY_ALL		/**< every record with a qualifying key is kept */
+};
+
+/** @brief Memory allocator used by a tree for its nodes.
+
+	A tree calls 'alloc' and 'release' for every block of memory it needs,
+	always passing along the 'context' pointer unchanged.  That lets you route
+	node memory into your own pools or arenas.  The allocator must remain
+	valid for as long as the tree holds memory from it. */
+struct splay_Allocator
+{
+	/**	Return at least 'size' bytes suitably aligned for any object,
+		or NULL if the request cannot be satisfied. */
+	void* (*alloc)(void* context, size_t size);
+
+	/**	Take back a block previously returned by 'alloc'. */
+	void (*release)(void* context, void* block);
+
+	void* context;	/**< opaque pointer passed to alloc and release */
+};
+
 struct splay_Node; /* deliberately left unspecified */
+struct splay_Arena; /* deliberately left unspecified */
 
 /** @brief Tree object, useful as a dictionary, set, multimap, or multiset */
 struct splay_Tree
@@ -37,6 +112,36 @@ struct splay_Tree
 		The user is welcome to read this field, but should not alter it.
 		Behavior is unspecified if the user changes this field. */
 	unsigned size;
+
+	/**	Opaque pointer to the slab allocator for the nodes, or NULL if the
+		nodes are allocated one at a time from the tree's allocator.
+		The user should not alter this field. */
+	struct splay_Arena *arena;
+
+	/**	Source of memory for the nodes (and arena chunks, if any).
+		The user should not alter this field. */
+	struct splay_Allocator alloc;
+};
+
+
+/** @brief Position in a tree, for in-order traversal without splaying.
+
+	A cursor remembers the path from the root to its current record, so each
+	step costs amortized constant time and leaves the tree unchanged.
+	Any operation that splays or modifies the tree invalidates its cursors,
+	except for the cursor functions themselves.  All fields are private. */
+struct splay_Cursor
+{
+	const struct splay_Tree* tree;	/**< tree being traversed */
+	const struct splay_Node** path;	/**< ancestors, and current node last */
+	unsigned depth;					/**< length of path; zero if off end */
+	unsigned cap;					/**< allocated length of path */
+	int failed;						/**< boolean: memory allocation failed */
+
+	/**	Copy of the tree's allocator, taken by the constructor, through which
+		the path is allocated and released.  So the cursor can still be
+		destroyed after its tree is destroyed, swapped or moved. */
+	struct splay_Allocator alloc;
 };
 
 
@@ -47,6 +152,11 @@ struct splay_Tree
 	@brief Creation, destruction, move, copy and clear */
 /** @{ */
 int splay_tree_empty_ctor(struct splay_Tree*);
+int splay_tree_slab_ctor(struct splay_Tree*, unsigned chunk_nodes);
+int splay_tree_alloc_ctor(struct splay_Tree*, const struct splay_Allocator*,
+							unsigned chunk_nodes);
+int splay_tree_from_sorted(struct splay_Tree*, const splay_Key keys[],
+							const splay_Satellite sats[], unsigned n);
 void splay_tree_dtor(struct splay_Tree* t);
 int splay_tree_copy(const struct splay_Tree* ti, struct splay_Tree* to);
 int splay_tree_move(struct splay_Tree* ti, struct splay_Tree* to); /*ti -> to*/
@@ -54,6 +164,35 @@ int splay_tree_clear(struct splay_Tree*);
 /** @} */
 
 
+/** @defgroup IntervalOps Interval Operations
+
+	@brief Store closed intervals and find those overlapping a query
+
+	These work only if the library was compiled with macro SPLAY_INTERVAL
+	set to a nonzero value; otherwise they just report failure. */
+/** @{ */
+int splay_interval_insert(struct splay_Tree* t, splay_Key lo, splay_Key hi,
+							splay_Satellite sat);
+int splay_interval_overlap(struct splay_Tree* t, splay_Key lo, splay_Key hi,
+							splay_IntervalVisitor visit, void* context);
+/** @} */
+
+
+/** @defgroup SetOps Set Operations
+
+	@brief Combine two trees into a new, balanced tree in linear time */
+/** @{ */
+int splay_tree_union(const struct splay_Tree* a, const struct splay_Tree* b,
+						struct splay_Tree* out, enum splay_Policy p);
+int splay_tree_intersection(const struct splay_Tree* a,
+						const struct splay_Tree* b, struct splay_Tree* out,
+						enum splay_Policy p);
+int splay_tree_difference(const struct splay_Tree* a,
+						const struct splay_Tree* b, struct splay_Tree* out,
+						enum splay_Policy p);
+/** @} */
+
+
 /** @defgroup DictOps Dictionary Operations
 
 	@brief Find, update, insert, erase
@@ -61,12 +200,126 @@ int splay_tree_clear(struct splay_Tree*);
 	Note that keys need not be unique values. */
 /** @{ */
 int splay_insert(struct splay_Tree* t, splay_Key k, splay_Satellite sat);
+int splay_insert_batch(struct splay_Tree* t, const splay_Key keys[],
+						const splay_Satellite sats[], unsigned n);
 int splay_update(struct splay_Tree* t, splay_Key k, splay_Satellite sat);
+int splay_upsert(struct splay_Tree* t, splay_Key k, splay_Satellite sat,
+						struct splay_Result* prior);
+int splay_insert_unique(struct splay_Tree* t, splay_Key k, splay_Satellite sat,
+						struct splay_Result* prior);
 int splay_erase(struct splay_Tree* t, splay_Key k, splay_Satellite* psat);
+int splay_erase_exact(struct splay_Tree* t, splay_Key k, splay_Satellite sat);
+int splay_erase_if(struct splay_Tree* t, splay_Key k, splay_Predicate pred,
+						void* context, splay_Satellite* psat);
+int splay_pop_min(struct splay_Tree* t, splay_Key* pk, splay_Satellite* psat);
+int splay_pop_max(struct splay_Tree* t, splay_Key* pk, splay_Satellite* psat);
 
 struct splay_Result splay_find(struct splay_Tree *t, splay_Key k);
+int splay_find_batch(struct splay_Tree *t, const splay_Key keys[], unsigned n,
+						struct splay_Result results[]);
 struct splay_Result splay_max(struct splay_Tree *t);
 struct splay_Result splay_min(struct splay_Tree *t);
+
+struct splay_Result splay_find_pred(struct splay_Tree *t, splay_Key k);
+struct splay_Result splay_find_pred_eq(struct splay_Tree *t, splay_Key k);
+struct splay_Result splay_find_succ(struct splay_Tree *t, splay_Key k);
+struct splay_Result splay_find_succ_eq(struct splay_Tree *t, splay_Key k);
+/** @} */
+
+
+/** @defgroup ReadOps Read-Only Operations
+
+	@brief Lookup without splaying, safe for concurrent readers
+
+	These do a plain BST descent and never restructure the tree, so their
+	cost is the depth of the key rather than amortized logarithmic time.
+
+	Reader/writer contract:  the library does no locking of its own.
+	Every function that takes a pointer to a const splay_Tree is a reader:
+	it never writes to the tree or its nodes, so any number of readers may
+	run at once on the same tree, e.g., under the shared side of a
+	reader/writer lock.  (That includes the cursors, the set operations,
+	splay_tree_copy(), splay_health_check(), splay_dot_output() and
+	splay_debug_print_tree(), which walk the tree with a path taken from
+	its allocator; the allocator then must tolerate concurrent calls, as
+	malloc does.)  Every other function
+	is a writer, including splay_find() and the other searches, because
+	splaying reshapes the tree.  A writer needs exclusive access, and it
+	invalidates all cursors on the tree when it finishes. */
+/** @{ */
+struct splay_Result splay_peek(const struct splay_Tree *t, splay_Key k);
+int splay_contains(const struct splay_Tree *t, splay_Key k);
+/** @} */
+
+
+/** @defgroup OrderOps Order Statistics
+
+	@brief Find by rank, and rank by key
+
+	These take logarithmic amortized time, but only if the library was
+	compiled with macro SPLAY_ORDER_STAT set to a nonzero value; otherwise
+	they just report failure. */
+/** @{ */
+struct splay_Result splay_select(struct splay_Tree *t, unsigned k);
+int splay_rank(struct splay_Tree *t, splay_Key k, unsigned* rank);
+/** @} */
+
+
+
+/** @defgroup SplitOps Split and Join
+
+	@brief Divide a tree at a key, or concatenate two trees
+
+	These take O(log n) amortized time, except that splitting sizes its
+	outputs by counting the smaller one, unless the library was compiled
+	with macro SPLAY_ORDER_STAT set to a nonzero value.  The resulting trees
+	share the memory source of the original tree. */
+/** @{ */
+int splay_split(struct splay_Tree* t, splay_Key k,
+				struct splay_Tree* lo_out, struct splay_Tree* hi_out);
+int splay_join(struct splay_Tree* lo, struct splay_Tree* hi,
+				struct splay_Tree* out);
+/** @} */
+
+
+
+/** @defgroup RangeOps Range Operations
+
+	@brief Count, read, erase or aggregate the records with keys in a
+	closed interval
+
+	These splay the boundaries of the range, and take time proportional
+	to log(n) plus the number of records in the range, amortized. */
+/** @{ */
+unsigned splay_count_range(struct splay_Tree* t, splay_Key lo, splay_Key hi);
+unsigned splay_read_range(struct splay_Tree* t, splay_Key lo, splay_Key hi,
+					splay_Key keys[], splay_Satellite sats[], unsigned bufsz);
+unsigned splay_erase_range(struct splay_Tree* t, splay_Key lo, splay_Key hi,
+							splay_Visitor visit, void* context);
+#if SPLAY_AGGREGATE
+splay_Aggregate splay_range_aggregate(struct splay_Tree* t, splay_Key lo,
+										splay_Key hi);
+#endif
+/** @} */
+
+
+
+/** @defgroup CursorOps Cursor Operations
+
+	@brief Non-splaying in-order traversal
+
+	Each function that moves the cursor returns the record at its new
+	position.  A result with found == 0 means the cursor went off the end
+	(or, if the failed field is set, that memory allocation failed);
+	after that, only first, last and seek make it usable again. */
+/** @{ */
+int splay_cursor_ctor(struct splay_Cursor* c, const struct splay_Tree* t);
+void splay_cursor_dtor(struct splay_Cursor* c);
+struct splay_Result splay_cursor_first(struct splay_Cursor* c);
+struct splay_Result splay_cursor_last(struct splay_Cursor* c);
+struct splay_Result splay_cursor_next(struct splay_Cursor* c);
+struct splay_Result splay_cursor_prev(struct splay_Cursor* c);
+struct splay_Result splay_cursor_seek(struct splay_Cursor* c, splay_Key k);
 /** @} */
 
 
@@ -0,0 +1,333 @@
+/**
+	@file
+	@brief Implementation of a splay tree that stores duplicate keys in buckets.
+	@author Andrew Predoehl
+
+	Each bucket is one block from the tree's allocator:  the header, then
+	room for 'capacity' satellites, in the manner of a flexible array.  The
+	records occupy sats[first] through sats[first + count - 1], oldest
+	first; new records go on the end and erasures take from the front, so
+	both cost O(1).  When the end of a full bucket is reached, the records
+	are slid back to the start if at least half the slots are free there;
+	otherwise the bucket is replaced by one twice the size.  Either way the
+	cost is O(1) amortized.  A bucket is released when its last record is
+	erased, along with the node of its key.
+
+	The bucket is a block of its own, behind the satellite field of the
+	node, rather than part of the node:  nodes are private to splay.c, of
+	one fixed size (an arena hands them out in slabs), and they cannot move,
+	since their parents point at them; whereas a bucket must grow, and
+	moving it only takes an update of the one satellite field.  Nor can a
+	lone record be stored in the node without a bucket, since its satellite
+	could not be told apart from a bucket pointer.  So each distinct key
+	costs one more allocation, and each query one more indirection.
+
+	Insertion finds or creates the node of its key in a single descent,
+	via splay_insert_unique(), which leaves that node at the root; so the
+	splay_update() or splay_erase() that may follow costs O(1).  See
+	splay_bucket.h for the interface. */
+/*	Tab size: 4 */
+
+#include <stdlib.h>
+
+#include "splay_bucket.h"
+
+/** Satellite data of all the records with one key. */
+struct splay_Bucket
+{
+	unsigned first;				/* index of the oldest record in sats */
+	unsigned count;				/* number of records */
+	unsigned capacity;			/* number of slots allocated */
+	splay_Satellite sats[1];	/* really 'capacity' slots */
+};
+
+
+/* Bytes needed for a bucket with room for 'capacity' satellites. */
+static size_t bucket_bytes(unsigned capacity)
+{
+	return sizeof(struct splay_Bucket)
+			+ (capacity - 1) * sizeof(splay_Satellite);
+}
+
+
+/* Return a bucket with room for one more record at the end:  *old itself if
+   it has room, or can make room by sliding its records back to the start;
+   else a copy twice the size (or a new bucket of one slot, if old is NULL),
+   in which case *old is released.  Returns NULL if out of memory, leaving
+   *old alone. */
+static struct splay_Bucket* bucket_grow(
+	struct splay_Tree* t,
+	struct splay_Bucket* old
+)
+{
+	struct splay_Bucket* bk;
+	unsigned i, capacity = old ? 2 * old -> capacity : 1;
+
+	if (old && old -> first + old -> count < old -> capacity)
+		return old;
+	if (old && old -> first >= old -> capacity / 2 && old -> first > 0) {
+		for (i = 0; i < old -> count; ++i)
+			old -> sats[i] = old -> sats[old -> first + i];
+		old -> first = 0;
+		return old;
+	}
+
+	bk = (struct splay_Bucket*)
+			t -> alloc.alloc(t -> alloc.context, bucket_bytes(capacity));
+	if (NULL == bk)
+		return NULL;
+
+	bk -> capacity = capacity;
+	bk -> first = bk -> count = 0;
+	if (old) {
+		for (i = 0; i < old -> count; ++i)
+			bk -> sats[i] = old -> sats[old -> first + i];
+		bk -> count = old -> count;
+		t -> alloc.release(t -> alloc.context, old);
+	}
+	return bk;
+}
+
+
+/* Convert a result from the underlying tree to report the oldest record. */
+static struct splay_Result first_of(struct splay_Result r)
+{
+	const struct splay_Bucket* bk = (const struct splay_Bucket*) r.sat;
+
+	if (r.found)
+		r.sat = bk -> sats[bk -> first];
+	return r;
+}
+
+
+/* Remove the oldest record of bucket *bk, which holds key k and is at the
+   root of the underlying tree.  If that empties the bucket, the node goes
+   too, in O(1) time since it is at the root. */
+static void bucket_pop(
+	struct splay_BucketTree* b,
+	struct splay_Bucket* bk,
+	splay_Key k,
+	splay_Satellite* psat
+)
+{
+	if (psat)
+		*psat = bk -> sats[bk -> first];
+	bk -> first += 1;
+	bk -> count -= 1;
+	if (0 == bk -> count) {
+		splay_erase(& b -> tree, k, NULL);
+		b -> tree.alloc.release(b -> tree.alloc.context, bk);
+	}
+	b -> size -= 1;
+}
+
+
+/** @brief Constructor for an empty bucket tree, using malloc() for memory.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (if b equals NULL).
+
+	@note This is a constructor function. */
+int splay_bucket_tree_ctor(struct splay_BucketTree* b)
+{
+	if (NULL == b || splay_tree_empty_ctor(& b -> tree) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	b -> size = 0;
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Destructor:  release the nodes and buckets.
+
+	Satellite data is not released.  Safe to call on NULL. */
+void splay_bucket_tree_dtor(struct splay_BucketTree* b)
+{
+	splay_Satellite bk;
+
+	if (NULL == b)
+		return;
+
+	/* Popping in key order costs O(1) amortized apiece. */
+	while (splay_pop_min(& b -> tree, NULL, &bk) == EXIT_SUCCESS)
+		b -> tree.alloc.release(b -> tree.alloc.context, bk);
+	splay_tree_dtor(& b -> tree);
+	b -> size = 0;
+}
+
+
+/** @brief Add record (k, sat) to the end of the bucket for key k.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (bad arguments or out of memory,
+	in which case the tree keeps its records). */
+int splay_bucket_insert(
+	struct splay_BucketTree* b,
+	splay_Key k,
+	splay_Satellite sat
+)
+{
+	struct splay_Result prior;
+	struct splay_Bucket *old, *bk;
+
+	if (NULL == b
+			|| splay_insert_unique(& b -> tree, k, NULL, &prior) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+
+	/* Either way, the node for key k is now at the root. */
+	old = prior.found ? (struct splay_Bucket*) prior.sat : NULL;
+	if (NULL == (bk = bucket_grow(& b -> tree, old))) {
+		if (NULL == old)
+			splay_erase(& b -> tree, k, NULL);
+		return EXIT_FAILURE;
+	}
+	bk -> sats[bk -> first + bk -> count++] = sat;
+	if (bk != old)
+		splay_update(& b -> tree, k, bk);
+
+	b -> size += 1;
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Replace the satellite data of the oldest record with key k.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (if k is not found). */
+int splay_bucket_update(
+	struct splay_BucketTree* b,
+	splay_Key k,
+	splay_Satellite sat
+)
+{
+	struct splay_Result r;
+	struct splay_Bucket* bk;
+
+	if (NULL == b || ! (r = splay_find(& b -> tree, k)).found)
+		return EXIT_FAILURE;
+	bk = (struct splay_Bucket*) r.sat;
+	bk -> sats[bk -> first] = sat;
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Erase the oldest record with key k, if any.
+
+	That is the record splay_bucket_find() reports.
+
+	@param b			Tree to modify
+	@param k			Key of the record to erase
+	@param[out] psat	Pointer to storage for its satellite data, or NULL
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (if k is not found). */
+int splay_bucket_erase(
+	struct splay_BucketTree* b,
+	splay_Key k,
+	splay_Satellite* psat
+)
+{
+	struct splay_Result r;
+
+	if (NULL == b || ! (r = splay_find(& b -> tree, k)).found)
+		return EXIT_FAILURE;
+	bucket_pop(b, (struct splay_Bucket*) r.sat, k, psat);
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Remove the oldest record with the maximum key, and report it.
+
+	@param b			Tree to modify
+	@param[out] pk		Pointer to storage for the key, or NULL
+	@param[out] psat	Pointer to storage for the satellite data, or NULL
+
+	This searches once; the node of the key, if its bucket empties, is
+	removed from the root.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (if the tree is empty). */
+int splay_bucket_pop_max(
+	struct splay_BucketTree* b,
+	splay_Key* pk,
+	splay_Satellite* psat
+)
+{
+	struct splay_Result r;
+
+	if (NULL == b || ! (r = splay_max(& b -> tree)).found)
+		return EXIT_FAILURE;
+	if (pk)
+		*pk = r.key;
+	bucket_pop(b, (struct splay_Bucket*) r.sat, r.key, psat);
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Find key k and report its oldest record. */
+struct splay_Result splay_bucket_find(struct splay_BucketTree* b, splay_Key k)
+{
+	struct splay_Result r = {0, 0, NULL};
+	return b ? first_of(splay_find(& b -> tree, k)) : r;
+}
+
+
+/** @brief Find all the records with key k.
+
+	@param b			Tree to search
+	@param k			Key to find
+	@param[out] count	Pointer to storage for the number of records
+
+	@returns a pointer to the satellite data of the *count records, oldest
+	first, or NULL (and *count is zero) if k is not found.  The array is
+	valid until the next insertion or erasure of a record with key k,
+	or the destruction of the tree. */
+const splay_Satellite* splay_bucket_find_all(
+	struct splay_BucketTree* b,
+	splay_Key k,
+	unsigned* count
+)
+{
+	struct splay_Result r;
+	const struct splay_Bucket* bk;
+
+	if (count)
+		*count = 0;
+	if (NULL == b || NULL == count || ! (r = splay_find(& b -> tree, k)).found)
+		return NULL;
+	bk = (const struct splay_Bucket*) r.sat;
+	*count = bk -> count;
+	return bk -> sats + bk -> first;
+}
+
+
+/** @brief Find the minimum key, and report its oldest record. */
+struct splay_Result splay_bucket_min(struct splay_BucketTree* b)
+{
+	struct splay_Result r = {0, 0, NULL};
+	return b ? first_of(splay_min(& b -> tree)) : r;
+}
+
+
+/** @brief Find the maximum key, and report its oldest record. */
+struct splay_Result splay_bucket_max(struct splay_BucketTree* b)
+{
+	struct splay_Result r = {0, 0, NULL};
+	return b ? first_of(splay_max(& b -> tree)) : r;
+}
+
+
+/** @brief Find the greatest key less than k, and report its oldest record. */
+struct splay_Result splay_bucket_find_pred(
+	struct splay_BucketTree* b,
+	splay_Key k
+)
+{
+	struct splay_Result r = {0, 0, NULL};
+	return b ? first_of(splay_find_pred(& b -> tree, k)) : r;
+}
+
+
+/** @brief Find the least key greater than k, and report its oldest record. */
+struct splay_Result splay_bucket_find_succ(
+	struct splay_BucketTree* b,
+	splay_Key k
+)
+{
+	struct splay_Result r = {0, 0, NULL};
+	return b ? first_of(splay_find_succ(& b -> tree, k)) : r;
+}
@@ -0,0 +1,72 @@
+/**
+	@file
+	@brief Interface for a splay tree that stores duplicate keys in buckets.
+	@author Andrew Predoehl
+
+	A splay_Tree stores every record in a node of its own, so a key with
+	many records makes the tree that much taller around the key, and every
+	search nearby pays for it.  A bucket tree stores each distinct key in a
+	single node, together with a compact, growable array (a bucket) holding
+	the satellite data of all the records with that key, in the order they
+	were inserted.  Duplicates then cost one array slot apiece, and all the
+	records with a key can be had at once, without a range query.
+
+	The underlying tree is an ordinary splay_Tree with unique keys, whose
+	satellite data are the buckets.  Functions of splay.h that do not
+	interpret satellite data, such as splay_health_check() and
+	splay_dot_output(), may be applied to it directly; nothing may modify
+	it except the functions below.  Buckets get memory from the allocator
+	of the underlying tree. */
+/*	Tab size: 4 */
+
+#ifndef PREDOEHL_SPLAY_BUCKET_H_2018_INCLUDED_
+#define PREDOEHL_SPLAY_BUCKET_H_2018_INCLUDED_ 1
+
+#include "splay.h"
+
+/** @brief Splay tree holding one node per distinct key */
+struct splay_BucketTree
+{
+	/**	Underlying tree; its size field is the number of distinct keys.
+		The user may read it, but should not alter it. */
+	struct splay_Tree tree;
+
+	/**	Number of records in all the buckets.
+		The user may read this field, but should not alter it. */
+	unsigned size;
+};
+
+
+/** @defgroup BucketOps Bucket Tree Operations
+
+	@brief Multimap operations with duplicate keys stored in buckets
+
+	These return EXIT_SUCCESS or EXIT_FAILURE, or a splay_Result, like
+	their counterparts in splay.h.  Within a bucket, the oldest record is
+	the one that a result reports, that an update replaces, and that an
+	erasure removes; so a bucket behaves as a queue. */
+/** @{ */
+int splay_bucket_tree_ctor(struct splay_BucketTree* b);
+void splay_bucket_tree_dtor(struct splay_BucketTree* b);
+
+int splay_bucket_insert(struct splay_BucketTree* b, splay_Key k,
+						splay_Satellite sat);
+int splay_bucket_update(struct splay_BucketTree* b, splay_Key k,
+						splay_Satellite sat);
+int splay_bucket_erase(struct splay_BucketTree* b, splay_Key k,
+						splay_Satellite* psat);
+int splay_bucket_pop_max(struct splay_BucketTree* b, splay_Key* pk,
+						splay_Satellite* psat);
+
+struct splay_Result splay_bucket_find(struct splay_BucketTree* b, splay_Key k);
+const splay_Satellite* splay_bucket_find_all(struct splay_BucketTree* b,
+						splay_Key k, unsigned* count);
+struct splay_Result splay_bucket_min(struct splay_BucketTree* b);
+struct splay_Result splay_bucket_max(struct splay_BucketTree* b);
+struct splay_Result splay_bucket_find_pred(struct splay_BucketTree* b,
+						splay_Key k);
+struct splay_Result splay_bucket_find_succ(struct splay_BucketTree* b,
+						splay_Key k);
+/** @} */
+
+#endif
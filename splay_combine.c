@@ -0,0 +1,302 @@
+/**
+	@file
+	@brief Implementation of a flat-combining front end to a splay tree.
+	@author Andrew Predoehl
+
+	A slot holds one request at a time.  Its owner thread fills in the
+	request, then sets the 'pending' flag with release semantics.  The
+	combiner reads the flag with acquire semantics, applies the request,
+	writes the results, and clears the flag with release semantics; the
+	owner sees the cleared flag with acquire semantics before it reads the
+	results.  So the flag is the only field accessed by two threads at once.
+
+	Slots are handed out and taken back under the combiner lock, which is
+	also the only time the count of slots in use changes.  The slot array
+	is aligned to a cache line, and the slots are spaced a whole number of
+	cache lines apart, so threads polling their flags do not disturb one
+	another.  See
+	splay_combine.h for the interface. */
+/*	Tab size: 4 */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L /**< for sched_yield, posix_memalign */
+#endif
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#include "splay_combine.h"
+
+/* The slot flags need GCC's __atomic builtins (GCC 4.7 and later, Clang). */
+#ifndef __ATOMIC_ACQUIRE
+#error "splay_combine.c requires a compiler with the __atomic builtins"
+#endif
+
+/** Alignment of the slots, so no two of them share a cache line. */
+#define SPLAY_CACHE_LINE 64
+
+/** The combiner rescans the slots until a pass finds no requests,
+	but makes at most this many passes per turn. */
+#define SPLAY_COMBINE_PASSES 4
+
+/** A waiting thread checks its flag this many times between attempts to
+	become the combiner, and yields the processor after each round. */
+#define SPLAY_COMBINE_SPINS 256
+
+/** Kinds of request that can be published in a slot. */
+enum splay_Request { FC_INSERT, FC_UPDATE, FC_ERASE, FC_FIND };
+
+/** One thread's mailbox for requests to the combiner. */
+struct splay_Slot
+{
+	struct splay_Combiner* owner;	/**< combiner this slot belongs to */
+	int in_use;						/**< boolean; guarded by combiner lock */
+	enum splay_Request op;			/**< kind of request */
+	splay_Key key;					/**< request argument */
+	splay_Satellite sat;			/**< request argument, or erased data */
+	int rc;							/**< return code of the request */
+	struct splay_Result result;		/**< result of a find request */
+	int pending;					/**< boolean; accessed atomically */
+};
+
+/** Distance between consecutive slots:  a whole number of cache lines. */
+#define SLOT_STRIDE ((sizeof(struct splay_Slot) + SPLAY_CACHE_LINE - 1) \
+						/ SPLAY_CACHE_LINE * SPLAY_CACHE_LINE)
+
+struct splay_CombinerLock
+{
+	pthread_mutex_t mutex;
+};
+
+
+/* Slot number i of combiner *c. */
+static struct splay_Slot* slot_at(struct splay_Combiner* c, unsigned i)
+{
+	return (struct splay_Slot*) ((char*) c -> slots + i * SLOT_STRIDE);
+}
+
+
+/* Perform the request in slot *s on tree *t. */
+static void apply(struct splay_Tree* t, struct splay_Slot* s)
+{
+	switch (s -> op) {
+		case FC_INSERT:
+			s -> rc = splay_insert(t, s -> key, s -> sat);
+			break;
+		case FC_UPDATE:
+			s -> rc = splay_update(t, s -> key, s -> sat);
+			break;
+		case FC_ERASE:
+			s -> rc = splay_erase(t, s -> key, & s -> sat);
+			break;
+		case FC_FIND:
+			s -> result = splay_find(t, s -> key);
+			s -> rc = s -> result.found ? EXIT_SUCCESS : EXIT_FAILURE;
+			break;
+	}
+}
+
+
+/* Serve all published requests.  The caller must hold the combiner lock. */
+static void combine(struct splay_Combiner* c)
+{
+	unsigned pass, i, served;
+
+	for (pass = 0; pass < SPLAY_COMBINE_PASSES; ++pass) {
+		for (served = i = 0; i < c -> used; ++i) {
+			struct splay_Slot* s = slot_at(c, i);
+			if (__atomic_load_n(& s -> pending, __ATOMIC_ACQUIRE)) {
+				apply(c -> tree, s);
+				__atomic_store_n(& s -> pending, 0, __ATOMIC_RELEASE);
+				served += 1;
+			}
+		}
+		if (0 == served)
+			break;
+	}
+}
+
+
+/* Publish the request filled into slot *s, and wait until it is served,
+   either by another thread or by becoming the combiner ourselves. */
+static void submit(struct splay_Slot* s)
+{
+	struct splay_Combiner* c = s -> owner;
+	unsigned spins;
+
+	__atomic_store_n(& s -> pending, 1, __ATOMIC_RELEASE);
+	for (;;) {
+		if (0 == pthread_mutex_trylock(& c -> lock -> mutex)) {
+			combine(c);
+			pthread_mutex_unlock(& c -> lock -> mutex);
+		}
+
+		for (spins = 0; spins < SPLAY_COMBINE_SPINS; ++spins)
+			if (! __atomic_load_n(& s -> pending, __ATOMIC_ACQUIRE))
+				return;
+		sched_yield();
+	}
+}
+
+
+/** @brief Constructor for a combiner guarding tree *t.
+
+	@param c		Combiner to construct
+	@param t		Tree to share; it must outlive the combiner
+	@param capacity	Maximum number of slots, i.e., of threads using *c
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (bad arguments or out of memory).
+
+	@note This is a constructor function. */
+int splay_combiner_ctor(
+	struct splay_Combiner* c,
+	struct splay_Tree* t,
+	unsigned capacity
+)
+{
+	void* block;
+
+	if (NULL == c || NULL == t || 0 == capacity)
+		return EXIT_FAILURE;
+
+	c -> tree = t;
+	c -> capacity = capacity;
+	c -> used = 0;
+	c -> slots = NULL;
+	if (0 == posix_memalign(&block, SPLAY_CACHE_LINE, capacity * SLOT_STRIDE))
+		c -> slots = (struct splay_Slot*) block;
+	c -> lock = (struct splay_CombinerLock*) malloc(sizeof(*c -> lock));
+
+	if (NULL == c -> slots || NULL == c -> lock
+			|| 0 != pthread_mutex_init(& c -> lock -> mutex, NULL)) {
+		free(c -> slots);
+		free(c -> lock);
+		c -> slots = NULL;
+		c -> lock = NULL;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Destructor; the tree itself is not affected.  Safe to call on NULL.
+
+	No thread may be using the combiner, and all its slots become invalid. */
+void splay_combiner_dtor(struct splay_Combiner* c)
+{
+	if (NULL == c || NULL == c -> lock)
+		return;
+
+	pthread_mutex_destroy(& c -> lock -> mutex);
+	free(c -> lock);
+	free(c -> slots);
+	c -> lock = NULL;
+	c -> slots = NULL;
+	c -> capacity = c -> used = 0;
+}
+
+
+/** @brief Take a slot for the calling thread to use with combiner *c.
+
+	@returns the slot, or NULL if all slots are taken. */
+struct splay_Slot* splay_combiner_slot(struct splay_Combiner* c)
+{
+	struct splay_Slot* s = NULL;
+	unsigned i;
+
+	if (NULL == c || 0 != pthread_mutex_lock(& c -> lock -> mutex))
+		return NULL;
+
+	for (i = 0; i < c -> used && NULL == s; ++i)
+		if (! slot_at(c, i) -> in_use)
+			s = slot_at(c, i);
+	if (NULL == s && c -> used < c -> capacity)
+		s = slot_at(c, c -> used++);
+
+	if (s) {
+		s -> owner = c;
+		s -> in_use = 1;
+		s -> pending = 0;
+	}
+	pthread_mutex_unlock(& c -> lock -> mutex);
+	return s;
+}
+
+
+/** @brief Give back a slot, e.g., when its thread finishes.
+
+	Safe to call on NULL. */
+void splay_combiner_release_slot(struct splay_Slot* s)
+{
+	if (s && 0 == pthread_mutex_lock(& s -> owner -> lock -> mutex)) {
+		s -> in_use = 0;
+		pthread_mutex_unlock(& s -> owner -> lock -> mutex);
+	}
+}
+
+
+/** @brief Insert record (k, sat), via the combiner. */
+int splay_combined_insert(
+	struct splay_Slot* s,
+	splay_Key k,
+	splay_Satellite sat
+)
+{
+	if (NULL == s)
+		return EXIT_FAILURE;
+	s -> op = FC_INSERT;
+	s -> key = k;
+	s -> sat = sat;
+	submit(s);
+	return s -> rc;
+}
+
+
+/** @brief Update a record with key k, via the combiner. */
+int splay_combined_update(
+	struct splay_Slot* s,
+	splay_Key k,
+	splay_Satellite sat
+)
+{
+	if (NULL == s)
+		return EXIT_FAILURE;
+	s -> op = FC_UPDATE;
+	s -> key = k;
+	s -> sat = sat;
+	submit(s);
+	return s -> rc;
+}
+
+
+/** @brief Erase one record with key k, via the combiner. */
+int splay_combined_erase(
+	struct splay_Slot* s,
+	splay_Key k,
+	splay_Satellite* psat
+)
+{
+	if (NULL == s)
+		return EXIT_FAILURE;
+	s -> op = FC_ERASE;
+	s -> key = k;
+	submit(s);
+	if (EXIT_SUCCESS == s -> rc && psat)
+		*psat = s -> sat;
+	return s -> rc;
+}
+
+
+/** @brief Find key k, via the combiner. */
+struct splay_Result splay_combined_find(struct splay_Slot* s, splay_Key k)
+{
+	struct splay_Result r = {0, 0, NULL};
+
+	if (NULL == s)
+		return r;
+	s -> op = FC_FIND;
+	s -> key = k;
+	submit(s);
+	return s -> result;
+}
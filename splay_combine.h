@@ -0,0 +1,68 @@
+/**
+	@file
+	@brief Interface for a flat-combining front end to a shared splay tree.
+	@author Andrew Predoehl
+
+	Every search in a splay tree writes near the root, so finer-grained
+	locking cannot help, and a plain mutex makes the tree's cache lines
+	bounce from core to core.  Flat combining (Hendler, Incze, Shavit and
+	Tzafrir, 2010) instead has each thread publish its request in a slot of
+	its own.  Whichever thread manages to take the combiner lock applies
+	all the published requests in one batch, then hands back the results.
+	The tree stays hot in the combiner's cache, and the lock changes hands
+	once per batch instead of once per operation.
+
+	Usage:  construct a splay_Combiner around an existing tree, and have
+	each thread take a slot with splay_combiner_slot() once, before calling
+	the operations below through its slot.  A thread must not share its
+	slot with another thread.  While the combiner exists, all access to
+	the tree must go through it.
+
+	This uses POSIX threads, and GCC's __atomic builtins for the slots
+	(GCC 4.7 or later, or Clang); splay_combine.c will not compile without
+	them. */
+/*	Tab size: 4 */
+
+#ifndef PREDOEHL_SPLAY_COMBINE_H_2018_INCLUDED_
+#define PREDOEHL_SPLAY_COMBINE_H_2018_INCLUDED_ 1
+
+#include "splay.h"
+
+struct splay_Slot; /* deliberately left unspecified */
+struct splay_CombinerLock; /* deliberately left unspecified */
+
+/** @brief Flat-combining wrapper for one tree; all fields are private. */
+struct splay_Combiner
+{
+	struct splay_Tree *tree;		/**< the shared tree (not owned) */
+	struct splay_Slot *slots;		/**< 'capacity' cache-aligned slots */
+	unsigned capacity;				/**< maximum number of slots */
+	unsigned used;					/**< slots ever handed out */
+	struct splay_CombinerLock *lock; /**< held by the current combiner */
+};
+
+
+/** @defgroup CombineOps Flat-Combining Operations
+
+	@brief Thread-safe tree operations applied in batches
+
+	The operations have the same meaning and return values as their
+	counterparts in splay.h.  They return failure if the slot is NULL.
+	Construction and destruction are not thread safe. */
+/** @{ */
+int splay_combiner_ctor(struct splay_Combiner* c, struct splay_Tree* t,
+						unsigned capacity);
+void splay_combiner_dtor(struct splay_Combiner* c);
+struct splay_Slot* splay_combiner_slot(struct splay_Combiner* c);
+void splay_combiner_release_slot(struct splay_Slot* s);
+
+int splay_combined_insert(struct splay_Slot* s, splay_Key k,
+							splay_Satellite sat);
+int splay_combined_update(struct splay_Slot* s, splay_Key k,
+							splay_Satellite sat);
+int splay_combined_erase(struct splay_Slot* s, splay_Key k,
+							splay_Satellite* psat);
+struct splay_Result splay_combined_find(struct splay_Slot* s, splay_Key k);
+/** @} */
+
+#endif
@@ -0,0 +1,611 @@
+/**
+	@file
+	@brief Generator of splay trees specialized to a particular key type.
+	@author Andrew Predoehl
+
+	The main library (splay.h) uses int keys, compared with the less-than
+	operator.  If you need another key type, you could call a comparison
+	function through a pointer, but that costs an indirect call at every step
+	of every search.  Instead, this header provides two macros that stamp out
+	a complete tree implementation for one key type, with the comparison
+	expanded inline:
+
+	@code
+	#define U64_LESS(a,b) ((a) < (b))
+	SPLAY_DECLARE(ts, unsigned long)             -- in a header
+	SPLAY_DEFINE(ts, unsigned long, U64_LESS)    -- in exactly one .c file
+	@endcode
+
+	That declares struct ts_Tree, struct ts_Result and functions
+	ts_tree_empty_ctor(), ts_insert(), ts_find(), and so on, which behave
+	like their splay_ counterparts in splay.h:  keys need not be unique,
+	satellite data are void pointers, and functions that return int return
+	EXIT_SUCCESS or EXIT_FAILURE.
+
+	The LESS argument must be the name of a function-like macro or of a
+	function taking two keys, which returns nonzero iff the first is less than
+	the second, under a strict weak order.  Each argument is evaluated at most
+	once per call.  The key type must be assignable, so to use a fixed-length
+	byte string as a key, wrap the array in a struct and compare with memcmp.
+
+	The generated code performs the simple top-down splay of Sleator and
+	Tarjan.  It is separate from the engine of splay.c, whose nodes carry
+	the optional augmentation and arena machinery, and whose comparisons
+	are fixed at compile time of the library; a generator must expand the
+	whole algorithm anew for each key type anyway.  It covers the basic
+	dictionary operations, the predecessor and successor queries, and
+	counting and reading a key range; the order, cursor and bulk operations
+	of splay.h are not generated.  Nodes are allocated with malloc() and
+	released with free().  See driver6.c for an example. */
+/*	Tab size: 4 */
+
+#ifndef PREDOEHL_SPLAY_DEFINE_H_2018_INCLUDED_
+#define PREDOEHL_SPLAY_DEFINE_H_2018_INCLUDED_ 1
+
+#include <stdlib.h> /* for malloc, free, EXIT_SUCCESS, stuff like that. */
+
+
+/** @brief Declare the types and functions of a splay tree with keys of type
+	KeyT, with identifiers starting with the given name.  No semicolon. */
+#define SPLAY_DECLARE(name, KeyT) \
+struct name##_Node { \
+	KeyT key; \
+	void* sat; \
+	struct name##_Node *left, *right; \
+}; \
+ \
+struct name##_Tree { \
+	struct name##_Node *root;	/* private */ \
+	unsigned size;				/* number of records; read-only */ \
+}; \
+ \
+struct name##_Result { \
+	int found; \
+	KeyT key; \
+	void* sat; \
+}; \
+ \
+int name##_tree_empty_ctor(struct name##_Tree* t); \
+void name##_tree_dtor(struct name##_Tree* t); \
+int name##_tree_clear(struct name##_Tree* t); \
+int name##_insert(struct name##_Tree* t, KeyT k, void* sat); \
+int name##_update(struct name##_Tree* t, KeyT k, void* sat); \
+int name##_erase(struct name##_Tree* t, KeyT k, void** psat); \
+int name##_pop_min(struct name##_Tree* t, KeyT* pk, void** psat); \
+int name##_pop_max(struct name##_Tree* t, KeyT* pk, void** psat); \
+struct name##_Result name##_find(struct name##_Tree* t, KeyT k); \
+struct name##_Result name##_min(struct name##_Tree* t); \
+struct name##_Result name##_max(struct name##_Tree* t); \
+struct name##_Result name##_find_pred(struct name##_Tree* t, KeyT k); \
+struct name##_Result name##_find_pred_eq(struct name##_Tree* t, KeyT k); \
+struct name##_Result name##_find_succ(struct name##_Tree* t, KeyT k); \
+struct name##_Result name##_find_succ_eq(struct name##_Tree* t, KeyT k); \
+unsigned name##_count_range(struct name##_Tree* t, KeyT lo, KeyT hi); \
+unsigned name##_read_range(struct name##_Tree* t, KeyT lo, KeyT hi, \
+					KeyT keys[], void* sats[], unsigned bufsz);
+
+/** @brief Define the functions declared by SPLAY_DECLARE(name, KeyT), with
+	key comparison LESS.  Use it in exactly one translation unit, after
+	SPLAY_DECLARE.  No semicolon. */
+#define SPLAY_DEFINE(name, KeyT, LESS) \
+ \
+/* Result for "not found," with every field zero, as SPLAY_BLANK_RESULT in \
+   splay.c; a static object, since KeyT may be of any type. */ \
+static const struct name##_Result name##_blank_ = {0}; \
+ \
+/* Top-down splay for key k:  returns the new root, using the x=change(x) \
+   idiom.  If k is absent, the last node on the search path becomes root. */ \
+static struct name##_Node* name##_splay_(struct name##_Node* t, KeyT k) \
+{ \
+	struct name##_Node n, *l, *r, *y; \
+ \
+	if (NULL == t) \
+		return NULL; \
+ \
+	n.left = n.right = NULL; \
+	l = r = &n; \
+	for (;;) \
+		if (LESS(k, t -> key)) { \
+			if (NULL == t -> left) \
+				break; \
+			if (LESS(k, t -> left -> key)) { \
+				y = t -> left;					/* rotate right */ \
+				t -> left = y -> right; \
+				y -> right = t; \
+				t = y; \
+				if (NULL == t -> left) \
+					break; \
+			} \
+			r -> left = t;						/* link right */ \
+			r = t; \
+			t = t -> left; \
+		} \
+		else if (LESS(t -> key, k)) { \
+			if (NULL == t -> right) \
+				break; \
+			if (LESS(t -> right -> key, k)) { \
+				y = t -> right;					/* rotate left */ \
+				t -> right = y -> left; \
+				y -> left = t; \
+				t = y; \
+				if (NULL == t -> right) \
+					break; \
+			} \
+			l -> right = t;						/* link left */ \
+			l = t; \
+			t = t -> right; \
+		} \
+		else \
+			break; \
+ \
+	l -> right = t -> left;						/* assemble */ \
+	r -> left = t -> right; \
+	t -> left = n.right; \
+	t -> right = n.left; \
+	return t; \
+} \
+ \
+/* Top-down splay of the extreme node:  minimum if want_min, else maximum. */ \
+static struct name##_Node* name##_splay_end_( \
+	struct name##_Node* t, \
+	int want_min \
+) \
+{ \
+	struct name##_Node n, *l, *r, *y; \
+ \
+	if (NULL == t) \
+		return NULL; \
+ \
+	n.left = n.right = NULL; \
+	l = r = &n; \
+	if (want_min) \
+		while (t -> left) { \
+			y = t -> left; \
+			if (y -> left) { \
+				t -> left = y -> right; \
+				y -> right = t; \
+				t = y; \
+				if (NULL == t -> left) \
+					break; \
+			} \
+			r -> left = t; \
+			r = t; \
+			t = t -> left; \
+		} \
+	else \
+		while (t -> right) { \
+			y = t -> right; \
+			if (y -> right) { \
+				t -> right = y -> left; \
+				y -> left = t; \
+				t = y; \
+				if (NULL == t -> right) \
+					break; \
+			} \
+			l -> right = t; \
+			l = t; \
+			t = t -> right; \
+		} \
+ \
+	l -> right = t -> left; \
+	r -> left = t -> right; \
+	t -> left = n.right; \
+	t -> right = n.left; \
+	return t; \
+} \
+ \
+int name##_tree_empty_ctor(struct name##_Tree* t) \
+{ \
+	if (NULL == t) \
+		return EXIT_FAILURE; \
+	t -> root = NULL; \
+	t -> size = 0; \
+	return EXIT_SUCCESS; \
+} \
+ \
+/* Release all nodes by rotating left children up:  no recursion. */ \
+int name##_tree_clear(struct name##_Tree* t) \
+{ \
+	struct name##_Node *n, *y; \
+ \
+	if (NULL == t) \
+		return EXIT_FAILURE; \
+	for (n = t -> root; n; ) \
+		if (n -> left) { \
+			y = n -> left; \
+			n -> left = y -> right; \
+			y -> right = n; \
+			n = y; \
+		} \
+		else { \
+			y = n -> right; \
+			free(n); \
+			n = y; \
+		} \
+	return name##_tree_empty_ctor(t); \
+} \
+ \
+void name##_tree_dtor(struct name##_Tree* t) \
+{ \
+	name##_tree_clear(t); \
+} \
+ \
+int name##_insert(struct name##_Tree* t, KeyT k, void* sat) \
+{ \
+	struct name##_Node* n; \
+ \
+	if (NULL == t) \
+		return EXIT_FAILURE; \
+	n = (struct name##_Node*) malloc(sizeof(struct name##_Node)); \
+	if (NULL == n) \
+		return EXIT_FAILURE; \
+	n -> key = k; \
+	n -> sat = sat; \
+ \
+	if (NULL == (t -> root = name##_splay_(t -> root, k))) \
+		n -> left = n -> right = NULL; \
+	else if (LESS(k, t -> root -> key)) { \
+		n -> left = t -> root -> left; \
+		n -> right = t -> root; \
+		t -> root -> left = NULL; \
+	} \
+	else { \
+		n -> right = t -> root -> right; \
+		n -> left = t -> root; \
+		t -> root -> right = NULL; \
+	} \
+	t -> root = n; \
+	t -> size += 1; \
+	return EXIT_SUCCESS; \
+} \
+ \
+struct name##_Result name##_find(struct name##_Tree* t, KeyT k) \
+{ \
+	struct name##_Result r = name##_blank_; \
+ \
+	if (t && (t -> root = name##_splay_(t -> root, k)) != NULL \
+			&& ! LESS(k, t -> root -> key) && ! LESS(t -> root -> key, k)) { \
+		r.found = 1; \
+		r.key = t -> root -> key; \
+		r.sat = t -> root -> sat; \
+	} \
+	return r; \
+} \
+ \
+int name##_update(struct name##_Tree* t, KeyT k, void* sat) \
+{ \
+	if (! name##_find(t, k).found) \
+		return EXIT_FAILURE; \
+	t -> root -> sat = sat; \
+	return EXIT_SUCCESS; \
+} \
+ \
+int name##_erase(struct name##_Tree* t, KeyT k, void** psat) \
+{ \
+	struct name##_Node* radix; \
+ \
+	if (! name##_find(t, k).found) \
+		return EXIT_FAILURE; \
+ \
+	radix = t -> root; \
+	if (psat) \
+		*psat = radix -> sat; \
+	if (NULL == radix -> left) \
+		t -> root = radix -> right; \
+	else { \
+		t -> root = name##_splay_end_(radix -> left, 0); \
+		t -> root -> right = radix -> right; \
+	} \
+	free(radix); \
+	t -> size -= 1; \
+	return EXIT_SUCCESS; \
+} \
+ \
+/* Support for name##_min and name##_max. */ \
+static struct name##_Result name##_end_(struct name##_Tree* t, int want_min) \
+{ \
+	struct name##_Result r = name##_blank_; \
+ \
+	if (t && t -> root) { \
+		t -> root = name##_splay_end_(t -> root, want_min); \
+		r.found = 1; \
+		r.key = t -> root -> key; \
+		r.sat = t -> root -> sat; \
+	} \
+	return r; \
+} \
+ \
+struct name##_Result name##_min(struct name##_Tree* t) \
+{ \
+	return name##_end_(t, 1); \
+} \
+ \
+struct name##_Result name##_max(struct name##_Tree* t) \
+{ \
+	return name##_end_(t, 0); \
+} \
+ \
+/* Support for name##_pop_min and name##_pop_max. */ \
+static int name##_pop_( \
+	struct name##_Tree* t, \
+	int want_min, \
+	KeyT* pk, \
+	void** psat \
+) \
+{ \
+	struct name##_Node* radix; \
+ \
+	if (NULL == t || NULL == t -> root) \
+		return EXIT_FAILURE; \
+ \
+	radix = name##_splay_end_(t -> root, want_min); \
+	t -> root = want_min ? radix -> right : radix -> left; \
+	if (pk) \
+		*pk = radix -> key; \
+	if (psat) \
+		*psat = radix -> sat; \
+	free(radix); \
+	t -> size -= 1; \
+	return EXIT_SUCCESS; \
+} \
+ \
+int name##_pop_min(struct name##_Tree* t, KeyT* pk, void** psat) \
+{ \
+	return name##_pop_(t, 1, pk, psat); \
+} \
+ \
+int name##_pop_max(struct name##_Tree* t, KeyT* pk, void** psat) \
+{ \
+	return name##_pop_(t, 0, pk, psat); \
+} \
+ \
+/* Whether a search for bound k steers right at node p, as BOUND_RIGHT in \
+   splay.c:  if p's key is less than k, or not greater if inclusive. */ \
+static int name##_right_(const struct name##_Node* p, KeyT k, int inclusive) \
+{ \
+	return inclusive ? ! LESS(k, p -> key) : LESS(p -> key, k); \
+} \
+ \
+/* Top-down splay for bound k:  like name##_splay_, but it steers by \
+   name##_right_ and never stops early, so the last node queried becomes \
+   root.  Then every node in its left subtree steers right, and every node \
+   in its right subtree steers left. */ \
+static struct name##_Node* name##_bound_( \
+	struct name##_Node* t, \
+	KeyT k, \
+	int inclusive \
+) \
+{ \
+	struct name##_Node n, *l, *r, *y; \
+ \
+	if (NULL == t) \
+		return NULL; \
+ \
+	n.left = n.right = NULL; \
+	l = r = &n; \
+	for (;;) \
+		if (! name##_right_(t, k, inclusive)) { \
+			if (NULL == t -> left) \
+				break; \
+			if (! name##_right_(t -> left, k, inclusive)) { \
+				y = t -> left;					/* rotate right */ \
+				t -> left = y -> right; \
+				y -> right = t; \
+				t = y; \
+				if (NULL == t -> left) \
+					break; \
+			} \
+			r -> left = t;						/* link right */ \
+			r = t; \
+			t = t -> left; \
+		} \
+		else { \
+			if (NULL == t -> right) \
+				break; \
+			if (name##_right_(t -> right, k, inclusive)) { \
+				y = t -> right;					/* rotate left */ \
+				t -> right = y -> left; \
+				y -> left = t; \
+				t = y; \
+				if (NULL == t -> right) \
+					break; \
+			} \
+			l -> right = t;						/* link left */ \
+			l = t; \
+			t = t -> right; \
+		} \
+ \
+	l -> right = t -> left;						/* assemble */ \
+	r -> left = t -> right; \
+	t -> left = n.right; \
+	t -> right = n.left; \
+	return t; \
+} \
+ \
+/* Support for the predecessor and successor queries:  splay the last node \
+   that steers right (if want_pred) or the first node that steers left \
+   (otherwise), using name##_bound_ and maybe one more rotation. */ \
+static struct name##_Result name##_neighbor_( \
+	struct name##_Tree* t, \
+	KeyT k, \
+	int inclusive, \
+	int want_pred \
+) \
+{ \
+	struct name##_Result r = name##_blank_; \
+	struct name##_Node *root, *y; \
+ \
+	if (NULL == t || NULL == t -> root) \
+		return r; \
+ \
+	root = name##_bound_(t -> root, k, inclusive); \
+	if (! name##_right_(root, k, inclusive) == ! want_pred) \
+		r.found = 1;	/* the neighbor is at the root already */ \
+	else if (want_pred && root -> left) { \
+		y = name##_splay_end_(root -> left, 0); \
+		root -> left = y -> right; \
+		y -> right = root; \
+		root = y; \
+		r.found = 1; \
+	} \
+	else if (! want_pred && root -> right) { \
+		y = name##_splay_end_(root -> right, 1); \
+		root -> right = y -> left; \
+		y -> left = root; \
+		root = y; \
+		r.found = 1; \
+	} \
+ \
+	t -> root = root; \
+	if (r.found) { \
+		r.key = root -> key; \
+		r.sat = root -> sat; \
+	} \
+	return r; \
+} \
+ \
+struct name##_Result name##_find_pred(struct name##_Tree* t, KeyT k) \
+{ \
+	return name##_neighbor_(t, k, 0, 1); \
+} \
+ \
+struct name##_Result name##_find_pred_eq(struct name##_Tree* t, KeyT k) \
+{ \
+	return name##_neighbor_(t, k, 1, 1); \
+} \
+ \
+struct name##_Result name##_find_succ(struct name##_Tree* t, KeyT k) \
+{ \
+	return name##_neighbor_(t, k, 1, 0); \
+} \
+ \
+struct name##_Result name##_find_succ_eq(struct name##_Tree* t, KeyT k) \
+{ \
+	return name##_neighbor_(t, k, 0, 0); \
+} \
+ \
+/* Split tree t at bound k into the nodes that steer right (*lo) and the \
+   rest (*hi). */ \
+static void name##_split_( \
+	struct name##_Node* t, \
+	KeyT k, \
+	int inclusive, \
+	struct name##_Node** lo, \
+	struct name##_Node** hi \
+) \
+{ \
+	if (NULL == (t = name##_bound_(t, k, inclusive))) \
+		*lo = *hi = NULL; \
+	else if (name##_right_(t, k, inclusive)) { \
+		*lo = t; \
+		*hi = t -> right; \
+		t -> right = NULL; \
+	} \
+	else { \
+		*hi = t; \
+		*lo = t -> left; \
+		t -> left = NULL; \
+	} \
+} \
+ \
+/* Join trees lo and hi, every key of lo not exceeding any key of hi, by \
+   splaying the maximum of lo.  Returns the new root. */ \
+static struct name##_Node* name##_join_( \
+	struct name##_Node* lo, \
+	struct name##_Node* hi \
+) \
+{ \
+	if (NULL == lo) \
+		return hi; \
+	lo = name##_splay_end_(lo, 0); \
+	lo -> right = hi; \
+	return lo; \
+} \
+ \
+/* Build a balanced tree of the first n nodes of the vine at *head (a list \
+   linked through the right fields), advancing *head past them, as \
+   vine_to_tree in splay.c.  Recursion depth is about log2(n). */ \
+static struct name##_Node* name##_unvine_( \
+	struct name##_Node** head, \
+	unsigned n \
+) \
+{ \
+	struct name##_Node *left, *root; \
+ \
+	if (0 == n) \
+		return NULL; \
+	left = name##_unvine_(head, n / 2); \
+	root = *head; \
+	*head = root -> right; \
+	root -> left = left; \
+	root -> right = name##_unvine_(head, n - n / 2 - 1); \
+	return root; \
+} \
+ \
+/* Support for the range operations:  split off the nodes with keys in \
+   [lo, hi], flatten them to a vine by right rotations, copy the first bufsz \
+   records to keys[] and sats[] (when those are not NULL), rebuild them \
+   balanced and join the pieces again.  Returns the number of records in \
+   the range. */ \
+static unsigned name##_range_( \
+	struct name##_Tree* t, \
+	KeyT lo, \
+	KeyT hi, \
+	KeyT keys[], \
+	void* sats[], \
+	unsigned bufsz \
+) \
+{ \
+	struct name##_Node *left, *mid, *right, *head = NULL, **tail = &head, *y; \
+	unsigned count = 0; \
+ \
+	if (NULL == t || NULL == t -> root || LESS(hi, lo)) \
+		return 0; \
+ \
+	name##_split_(t -> root, lo, 0, &left, &mid); \
+	name##_split_(mid, hi, 1, &mid, &right); \
+	while (mid) \
+		if (mid -> left) { \
+			y = mid -> left; \
+			mid -> left = y -> right; \
+			y -> right = mid; \
+			mid = y; \
+		} \
+		else { \
+			if (count < bufsz) { \
+				if (keys) \
+					keys[count] = mid -> key; \
+				if (sats) \
+					sats[count] = mid -> sat; \
+			} \
+			*tail = mid; \
+			tail = & mid -> right; \
+			mid = mid -> right; \
+			count += 1; \
+		} \
+ \
+	mid = name##_unvine_(&head, count); \
+	t -> root = name##_join_(left, name##_join_(mid, right)); \
+	return count; \
+} \
+ \
+unsigned name##_count_range(struct name##_Tree* t, KeyT lo, KeyT hi) \
+{ \
+	return name##_range_(t, lo, hi, NULL, NULL, 0); \
+} \
+ \
+/* Like splay_read_range(), this returns the number of records in the range \
+   but writes only the first bufsz of them. */ \
+unsigned name##_read_range( \
+	struct name##_Tree* t, \
+	KeyT lo, \
+	KeyT hi, \
+	KeyT keys[], \
+	void* sats[], \
+	unsigned bufsz \
+) \
+{ \
+	return name##_range_(t, lo, hi, keys, sats, bufsz); \
+}
+
+#endif
@@ -0,0 +1,393 @@
+/**
+	@file
+	@brief Implementation of a sharded forest of splay trees.
+	@author Andrew Predoehl
+
+	Each shard is a splay_Tree plus a POSIX reader/writer lock.  Whenever
+	an operation needs more than one shard, it locks them in ascending
+	index order, which rules out deadlock among operations of the forest.
+	See splay_forest.h for the interface. */
+/*	Tab size: 4 */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L /**< for pthread_rwlock_t, posix_memalign */
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "splay_forest.h"
+
+/** Size and alignment of the shards, so no two share a cache line. */
+#define SPLAY_CACHE_LINE 64
+
+/** A tree and the lock that guards it. */
+struct shard_Body
+{
+	pthread_rwlock_t lock;
+	struct splay_Tree tree;
+};
+
+/** A shard_Body padded to a whole number of cache lines. */
+struct splay_Shard
+{
+	pthread_rwlock_t lock;
+	struct splay_Tree tree;
+	char pad[SPLAY_CACHE_LINE - sizeof(struct shard_Body) % SPLAY_CACHE_LINE];
+};
+
+/* Compile-time check that the padding came out right. */
+typedef char shard_size_check[
+				sizeof(struct splay_Shard) % SPLAY_CACHE_LINE ? -1 : 1];
+
+
+/* Which shard holds key k? */
+static unsigned shard_of(const struct splay_Forest* f, splay_Key k)
+{
+	unsigned lo = 0, hi = f -> count - 1;
+
+	if (NULL == f -> bounds) {
+		/* Fibonacci hashing, folded so the high bits matter too. */
+		unsigned long h = (unsigned long) (unsigned) k * 2654435761UL;
+		return (unsigned) ((h ^ (h >> 16)) % f -> count);
+	}
+
+	/* Count the split points not greater than k, by binary search. */
+	while (lo < hi) {
+		unsigned mid = lo + (hi - lo) / 2;
+		if (k < f -> bounds[mid])
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
+
+/* Lock shards first..last for writing (if 'write') or reading, in order.
+   On failure, release whatever was locked. */
+static int lock_shards(
+	struct splay_Forest* f,
+	unsigned first,
+	unsigned last,
+	int write
+)
+{
+	unsigned i;
+
+	for (i = first; i <= last; ++i)
+		if (0 != (write ? pthread_rwlock_wrlock(& f -> shards[i].lock)
+						: pthread_rwlock_rdlock(& f -> shards[i].lock))) {
+			while (i-- > first)
+				pthread_rwlock_unlock(& f -> shards[i].lock);
+			return EXIT_FAILURE;
+		}
+	return EXIT_SUCCESS;
+}
+
+
+/* Lock the shard that holds key k, for writing (if 'write') or reading.
+   Return it, or NULL if f is NULL or the lock cannot be had. */
+static struct splay_Shard* lock_key(
+	struct splay_Forest* f,
+	splay_Key k,
+	int write
+)
+{
+	unsigned i;
+
+	if (NULL == f)
+		return NULL;
+	i = shard_of(f, k);
+	return lock_shards(f, i, i, write) == EXIT_SUCCESS ? f -> shards + i : NULL;
+}
+
+
+static void unlock_shards(struct splay_Forest* f, unsigned first, unsigned last)
+{
+	unsigned i;
+	for (i = first; i <= last; ++i)
+		pthread_rwlock_unlock(& f -> shards[i].lock);
+}
+
+
+/** @brief Constructor for a forest of 'count' empty shards.
+
+	@param f		Forest to construct
+	@param count	Number of shards; must be positive
+	@param bounds	Either NULL, to partition keys by hash, or an array of
+					count-1 strictly ascending split points.  The forest
+					keeps its own copy.
+
+	@returns EXIT_SUCCESS or EXIT_FAILURE (bad arguments or out of memory).
+
+	@note This is a constructor function. */
+int splay_forest_ctor(
+	struct splay_Forest* f,
+	unsigned count,
+	const splay_Key bounds[]
+)
+{
+	unsigned i;
+	void* block;
+
+	if (NULL == f)
+		return EXIT_FAILURE;
+
+	/* Leave the forest safe to destroy, whatever happens below. */
+	f -> shards = NULL;
+	f -> bounds = NULL;
+	f -> count = 0;
+	if (0 == count)
+		return EXIT_FAILURE;
+
+	if (bounds) {
+		for (i = 1; i + 1 < count; ++i)
+			if (bounds[i] <= bounds[i - 1])
+				return EXIT_FAILURE;
+		if (count > 1 && NULL == (f -> bounds = (splay_Key*)
+								malloc((count - 1) * sizeof(splay_Key))))
+			return EXIT_FAILURE;
+		for (i = 0; i + 1 < count; ++i)
+			f -> bounds[i] = bounds[i];
+	}
+
+	/* Align the shards to cache lines, so no two of them share one. */
+	if (0 != posix_memalign(&block, SPLAY_CACHE_LINE,
+							count * sizeof(struct splay_Shard))) {
+		free(f -> bounds);
+		f -> bounds = NULL;
+		return EXIT_FAILURE;
+	}
+	f -> shards = (struct splay_Shard*) block;
+
+	for (i = 0; i < count; ++i)
+		if (0 != pthread_rwlock_init(& f -> shards[i].lock, NULL)) {
+			while (i-- > 0)
+				pthread_rwlock_destroy(& f -> shards[i].lock);
+			free(f -> shards);
+			free(f -> bounds);
+			f -> shards = NULL;
+			f -> bounds = NULL;
+			return EXIT_FAILURE;
+		}
+		else
+			splay_tree_empty_ctor(& f -> shards[i].tree);
+
+	f -> count = count;
+	return EXIT_SUCCESS;
+}
+
+
+/** @brief Destructor:  release all memory used by the forest.
+
+	Satellite data is not released.  No other thread may be using the
+	forest.  Safe to call on NULL. */
+void splay_forest_dtor(struct splay_Forest* f)
+{
+	unsigned i;
+
+	if (NULL == f || NULL == f -> shards)
+		return;
+
+	for (i = 0; i < f -> count; ++i) {
+		splay_tree_dtor(& f -> shards[i].tree);
+		pthread_rwlock_destroy(& f -> shards[i].lock);
+	}
+	free(f -> shards);
+	free(f -> bounds);
+	f -> shards = NULL;
+	f -> bounds = NULL;
+	f -> count = 0;
+}
+
+
+/** @brief Total number of records in all shards, as of one instant. */
+unsigned splay_forest_size(struct splay_Forest* f)
+{
+	unsigned i, size = 0;
+
+	if (NULL == f || lock_shards(f, 0, f -> count - 1, 0) != EXIT_SUCCESS)
+		return 0;
+	for (i = 0; i < f -> count; ++i)
+		size += f -> shards[i].tree.size;
+	unlock_shards(f, 0, f -> count - 1);
+	return size;
+}
+
+
+/** @brief Insert record (k, sat) into the appropriate shard. */
+int splay_forest_insert(
+	struct splay_Forest* f,
+	splay_Key k,
+	splay_Satellite sat
+)
+{
+	struct splay_Shard* s = lock_key(f, k, 1);
+	int rc;
+
+	if (NULL == s)
+		return EXIT_FAILURE;
+	rc = splay_insert(& s -> tree, k, sat);
+	pthread_rwlock_unlock(& s -> lock);
+	return rc;
+}
+
+
+/** @brief Update a record with key k to have satellite data sat. */
+int splay_forest_update(
+	struct splay_Forest* f,
+	splay_Key k,
+	splay_Satellite sat
+)
+{
+	struct splay_Shard* s = lock_key(f, k, 1);
+	int rc;
+
+	if (NULL == s)
+		return EXIT_FAILURE;
+	rc = splay_update(& s -> tree, k, sat);
+	pthread_rwlock_unlock(& s -> lock);
+	return rc;
+}
+
+
+/** @brief Erase one record with key k, if any. */
+int splay_forest_erase(
+	struct splay_Forest* f,
+	splay_Key k,
+	splay_Satellite* psat
+)
+{
+	struct splay_Shard* s = lock_key(f, k, 1);
+	int rc;
+
+	if (NULL == s)
+		return EXIT_FAILURE;
+	rc = splay_erase(& s -> tree, k, psat);
+	pthread_rwlock_unlock(& s -> lock);
+	return rc;
+}
+
+
+/** @brief Find key k, splaying its shard; takes the shard lock exclusively. */
+struct splay_Result splay_forest_find(struct splay_Forest* f, splay_Key k)
+{
+	struct splay_Result r = {0, 0, NULL};
+	struct splay_Shard* s = lock_key(f, k, 1);
+
+	if (s) {
+		r = splay_find(& s -> tree, k);
+		pthread_rwlock_unlock(& s -> lock);
+	}
+	return r;
+}
+
+
+/** @brief Find key k without splaying; takes the shard lock shared. */
+struct splay_Result splay_forest_peek(struct splay_Forest* f, splay_Key k)
+{
+	struct splay_Result r = {0, 0, NULL};
+	struct splay_Shard* s = lock_key(f, k, 0);
+
+	if (s) {
+		r = splay_peek(& s -> tree, k);
+		pthread_rwlock_unlock(& s -> lock);
+	}
+	return r;
+}
+
+
+/** @brief Test whether key k is present, without splaying. */
+int splay_forest_contains(struct splay_Forest* f, splay_Key k)
+{
+	return splay_forest_peek(f, k).found;
+}
+
+
+/* Find the shards that might hold keys in [lo, hi], and lock them. */
+static int lock_range(
+	struct splay_Forest* f,
+	splay_Key lo,
+	splay_Key hi,
+	unsigned* first,
+	unsigned* last
+)
+{
+	if (NULL == f || hi < lo)
+		return EXIT_FAILURE;
+
+	if (f -> bounds) {
+		*first = shard_of(f, lo);
+		*last = shard_of(f, hi);
+	}
+	else {
+		*first = 0;
+		*last = f -> count - 1;
+	}
+	return lock_shards(f, *first, *last, 1);
+}
+
+
+/** @brief Count the records with keys in [lo, hi], across all shards. */
+unsigned splay_forest_count_range(
+	struct splay_Forest* f,
+	splay_Key lo,
+	splay_Key hi
+)
+{
+	unsigned i, first, last, count = 0;
+
+	if (lock_range(f, lo, hi, &first, &last) != EXIT_SUCCESS)
+		return 0;
+	for (i = first; i <= last; ++i)
+		count += splay_count_range(& f -> shards[i].tree, lo, hi);
+	unlock_shards(f, first, last);
+	return count;
+}
+
+
+/** @brief Read the records with keys in [lo, hi], across all shards.
+
+	The parameters are as for splay_read_range().  Each shard in the range
+	is read once, into the space the shards before it left.
+	If the forest is partitioned by range, the records come out in key
+	order.  If it is partitioned by hash, they come out in key order
+	within each shard, but the shards are simply concatenated.
+
+	@returns EXIT_SUCCESS if all the records in the range were written,
+	or EXIT_FAILURE if f is NULL or the range holds more than bufsz records
+	(in which case the buffers are filled). */
+int splay_forest_read_range(
+	struct splay_Forest* f,
+	splay_Key lo,
+	splay_Key hi,
+	splay_Key keys[],
+	splay_Satellite sats[],
+	unsigned bufsz
+)
+{
+	unsigned i, first, last, n, done = 0;
+	int rc = EXIT_SUCCESS;
+
+	if (NULL == f)
+		return EXIT_FAILURE;
+	if (hi < lo)
+		return EXIT_SUCCESS;
+	if (lock_range(f, lo, hi, &first, &last) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+
+	for (i = first; i <= last && EXIT_SUCCESS == rc; ++i) {
+		n = splay_read_range(& f -> shards[i].tree, lo, hi,
+								keys ? keys + done : NULL,
+								sats ? sats + done : NULL, bufsz - done);
+		if (n > bufsz - done) {
+			n = bufsz - done;
+			rc = EXIT_FAILURE;
+		}
+		done += n;
+	}
+
+	unlock_shards(f, first, last);
+	return rc;
+}
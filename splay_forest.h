@@ -0,0 +1,72 @@
+/**
+	@file
+	@brief Interface for a sharded forest of splay trees, for many threads.
+	@author Andrew Predoehl
+
+	A splay tree rewrites its root on nearly every operation, so a single
+	tree shared by many threads serializes them all.  A forest partitions
+	the key space across several independent trees (shards), each with its
+	own reader/writer lock.  Operations on keys in different shards proceed
+	in parallel, while each shard still enjoys the locality of splaying.
+
+	Keys are assigned to shards either by range, using an ascending array
+	of split points given to the constructor, or by a hash of the key.
+	Range partitioning keeps range queries to the shards that overlap the
+	range, and yields records in key order.  Hash partitioning spreads
+	clustered keys more evenly, but every range query visits every shard.
+
+	Operations that splay (find, insert, erase, the range queries) take a
+	shard's lock exclusively.  splay_forest_peek() and
+	splay_forest_contains() take it shared, per the reader/writer contract
+	described in splay.h.  Queries spanning several shards lock them all,
+	in ascending order, so they see a consistent snapshot. */
+/*	Tab size: 4 */
+
+#ifndef PREDOEHL_SPLAY_FOREST_H_2018_INCLUDED_
+#define PREDOEHL_SPLAY_FOREST_H_2018_INCLUDED_ 1
+
+#include "splay.h"
+
+struct splay_Shard; /* deliberately left unspecified */
+
+/** @brief Sharded collection of splay trees; all fields are private. */
+struct splay_Forest
+{
+	struct splay_Shard *shards;	/**< array of 'count' shards */
+	unsigned count;				/**< number of shards */
+
+	/**	Ascending split points, count-1 of them, or NULL to partition by
+		hash.  Shard i holds the keys k with bounds[i-1] <= k < bounds[i]. */
+	splay_Key *bounds;
+};
+
+
+/** @defgroup ForestOps Sharded Forest Operations
+
+	@brief Thread-safe counterparts of the tree operations
+
+	These return EXIT_SUCCESS or EXIT_FAILURE like their counterparts in
+	splay.h.  Construction and destruction are not thread safe. */
+/** @{ */
+int splay_forest_ctor(struct splay_Forest* f, unsigned count,
+						const splay_Key bounds[]);
+void splay_forest_dtor(struct splay_Forest* f);
+unsigned splay_forest_size(struct splay_Forest* f);
+
+int splay_forest_insert(struct splay_Forest* f, splay_Key k,
+						splay_Satellite sat);
+int splay_forest_update(struct splay_Forest* f, splay_Key k,
+						splay_Satellite sat);
+int splay_forest_erase(struct splay_Forest* f, splay_Key k,
+						splay_Satellite* psat);
+struct splay_Result splay_forest_find(struct splay_Forest* f, splay_Key k);
+struct splay_Result splay_forest_peek(struct splay_Forest* f, splay_Key k);
+int splay_forest_contains(struct splay_Forest* f, splay_Key k);
+
+unsigned splay_forest_count_range(struct splay_Forest* f, splay_Key lo,
+									splay_Key hi);
+int splay_forest_read_range(struct splay_Forest* f, splay_Key lo, splay_Key hi,
+					splay_Key keys[], splay_Satellite sats[], unsigned bufsz);
+/** @} */
+
+#endif
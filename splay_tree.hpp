@@ -0,0 +1,877 @@
+/**
+	@file
+	@brief Header-only C++ splay tree map with keys and values stored inline.
+	@author Andrew Predoehl
+
+	This is a C++ counterpart of splay.h, for programs that would otherwise
+	wrap the C interface and box their values behind void pointers (see
+	cli.cpp).  Class template predoehl::splay_tree<K, V, Compare, Alloc> is a
+	map from unique keys of type K to values of type V, with an interface
+	modeled on std::map.  Each node holds a std::pair<const K, V> directly,
+	so there is one allocation per record and no indirection on lookup.
+
+	Lookups that splay (find, lower_bound, upper_bound, erase, insertion)
+	are only available on non-const trees, just like the C interface.
+	The const overloads of find, lower_bound, upper_bound and count perform
+	plain BST descents instead, which do not reshape the tree.
+
+	Splaying is top down, as in splay.c, in the simple form given by Sleator
+	and Tarjan.  The engine of splay.c is not reused:  it is C, fixed to the
+	key type and comparison macros of splay.h, and its nodes have no parent
+	pointers.  Here the nodes have parent pointers, so that iterators are
+	small bidirectional iterators usable with standard algorithms, which
+	stay valid while the tree splays -- unlike the cursors of splay.h,
+	which hold a path and are invalidated by every writer.  Iteration never
+	splays.  Every operation that splays leaves all iterators valid, since
+	nodes never move in memory; only erase invalidates iterators, and only
+	those referring to the erased record.
+
+	Stateless comparison objects and allocators are stored as empty base
+	classes, so they cost no space and the comparisons are inlined; others,
+	such as function pointers and final classes, are stored as members.
+	Values may be move-only types.  Requires C++11. */
+/*	Tab size: 4 */
+
+#ifndef PREDOEHL_SPLAY_TREE_HPP_2018_INCLUDED_
+#define PREDOEHL_SPLAY_TREE_HPP_2018_INCLUDED_ 1
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace predoehl {
+
+template <typename K, typename V, typename Compare, typename Alloc>
+class splay_tree;
+
+namespace splay_detail {
+
+#if __cplusplus >= 201402L
+template <typename T> struct is_final : std::is_final<T> {};
+#else
+template <typename T>
+struct is_final : std::integral_constant<bool, __is_final(T)> {};
+#endif
+
+/* Holder of a comparison object or allocator of type T.  An empty class
+   that can be derived from is a base, and takes no space in the derived
+   class; anything else (a function pointer, a final class, a class with
+   state) is a member.  The tag tells apart holders of the same type. */
+template <typename T, int Tag,
+			bool Base = std::is_empty<T>::value && ! is_final<T>::value>
+class holder : private T {
+public:
+	explicit holder(const T& t) : T(t) {}
+	explicit holder(T&& t) : T(std::move(t)) {}
+	T& get() { return *this; }
+	const T& get() const { return *this; }
+};
+
+template <typename T, int Tag>
+class holder<T, Tag, false> {
+public:
+	explicit holder(const T& t) : t_(t) {}
+	explicit holder(T&& t) : t_(std::move(t)) {}
+	T& get() { return t_; }
+	const T& get() const { return t_; }
+private:
+	T t_;
+};
+
+template <typename> struct make_void { typedef void type; };
+
+/* Do all allocators of type A compare equal?  That is
+   std::allocator_traits<A>::is_always_equal, where the library has it
+   (C++17); before that, an empty allocator is taken to be stateless. */
+template <typename A, typename = void>
+struct always_equal : std::is_empty<A> {};
+
+template <typename A>
+struct always_equal<A, typename make_void<
+					typename std::allocator_traits<A>::is_always_equal>::type>
+:	std::allocator_traits<A>::is_always_equal
+{};
+
+/* Links of a node, without the payload.  The tree's header is one of these:
+   its parent field points to the root, and the root's parent is the header.
+   The header also serves as the past-the-end position of iterators. */
+struct node_base {
+	node_base *left, *right, *parent;
+};
+
+/* Full node:  links plus raw storage for the record, which is constructed
+   separately through the allocator. */
+template <typename Value>
+struct node : node_base {
+	alignas(Value) unsigned char storage[sizeof(Value)];
+
+	Value* valptr() { return reinterpret_cast<Value*>(storage); }
+	const Value* valptr() const
+	{
+		return reinterpret_cast<const Value*>(storage);
+	}
+};
+
+/* Link setters that keep the parent pointers consistent. */
+inline void set_left(node_base* p, node_base* c)
+{
+	p -> left = c;
+	if (c)
+		c -> parent = p;
+}
+
+inline void set_right(node_base* p, node_base* c)
+{
+	p -> right = c;
+	if (c)
+		c -> parent = p;
+}
+
+inline node_base* leftmost(node_base* n)
+{
+	while (n -> left)
+		n = n -> left;
+	return n;
+}
+
+inline node_base* rightmost(node_base* n)
+{
+	while (n -> right)
+		n = n -> right;
+	return n;
+}
+
+/* In-order successor of n, or the header if n is the maximum. */
+inline node_base* next_node(node_base* n, const node_base* header)
+{
+	if (n -> right)
+		return leftmost(n -> right);
+
+	node_base* p = n -> parent;
+	while (p != header && n == p -> right) {
+		n = p;
+		p = p -> parent;
+	}
+	return p;
+}
+
+/* In-order predecessor of n, or the maximum if n is the header. */
+inline node_base* prev_node(node_base* n, const node_base* header)
+{
+	if (n == header)
+		return rightmost(n -> parent);
+	if (n -> left)
+		return rightmost(n -> left);
+
+	node_base* p = n -> parent;
+	while (n == p -> left) {
+		n = p;
+		p = p -> parent;
+	}
+	return p;
+}
+
+
+/* Bidirectional iterator over the records of a splay_tree. */
+template <typename Value, bool Const>
+class iterator_impl {
+public:
+	typedef std::bidirectional_iterator_tag iterator_category;
+	typedef Value value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef typename std::conditional<Const, const Value&, Value&>::type
+		reference;
+	typedef typename std::conditional<Const, const Value*, Value*>::type
+		pointer;
+
+	iterator_impl() : n_(nullptr), header_(nullptr) {}
+
+	/* Every iterator converts to a const_iterator. */
+	operator iterator_impl<Value, true>() const
+	{
+		return iterator_impl<Value, true>(n_, header_);
+	}
+
+	reference operator*() const { return *static_cast<node<Value>*>(n_) -> valptr(); }
+	pointer operator->() const { return static_cast<node<Value>*>(n_) -> valptr(); }
+
+	iterator_impl& operator++()
+	{
+		n_ = next_node(n_, header_);
+		return *this;
+	}
+
+	iterator_impl operator++(int)
+	{
+		iterator_impl i(*this);
+		++*this;
+		return i;
+	}
+
+	iterator_impl& operator--()
+	{
+		n_ = prev_node(n_, header_);
+		return *this;
+	}
+
+	iterator_impl operator--(int)
+	{
+		iterator_impl i(*this);
+		--*this;
+		return i;
+	}
+
+	friend bool operator==(const iterator_impl& a, const iterator_impl& b)
+	{
+		return a.n_ == b.n_;
+	}
+
+	friend bool operator!=(const iterator_impl& a, const iterator_impl& b)
+	{
+		return a.n_ != b.n_;
+	}
+
+private:
+	template <typename, typename, typename, typename>
+		friend class ::predoehl::splay_tree;
+	template <typename, bool> friend class iterator_impl;
+
+	iterator_impl(node_base* n, const node_base* header)
+	:	n_(n), header_(header)
+	{}
+
+	node_base* n_;
+	const node_base* header_;
+};
+
+} // end namespace splay_detail
+
+
+/** @brief Map from unique keys to values, implemented as a splay tree. */
+template <
+	typename K,
+	typename V,
+	typename Compare = std::less<K>,
+	typename Alloc = std::allocator<std::pair<const K, V> >
+>
+class splay_tree {
+public:
+	typedef K key_type;
+	typedef V mapped_type;
+	typedef std::pair<const K, V> value_type;
+	typedef Compare key_compare;
+	typedef Alloc allocator_type;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef value_type& reference;
+	typedef const value_type& const_reference;
+	typedef splay_detail::iterator_impl<value_type, false> iterator;
+	typedef splay_detail::iterator_impl<value_type, true> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+private:
+	typedef splay_detail::node_base node_base;
+	typedef splay_detail::node<value_type> node;
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<node>
+		node_allocator;
+	typedef std::allocator_traits<node_allocator> node_traits;
+
+	typedef splay_detail::holder<Compare, 0> compare_holder;
+	typedef splay_detail::holder<node_allocator, 1> allocator_holder;
+
+	/* Moving is noexcept when the nodes can change hands in every case. */
+	static const bool nothrow_move_assign =
+		(node_traits::propagate_on_container_move_assignment::value
+			|| splay_detail::always_equal<node_allocator>::value)
+		&& std::is_nothrow_copy_assignable<Compare>::value;
+
+	/* Comparator and allocator take no space when empty (see holder). */
+	struct impl : compare_holder, allocator_holder {
+		node_base header;
+		size_type count;
+
+		impl(const Compare& c, const node_allocator& a)
+		:	compare_holder(c), allocator_holder(a), count(0)
+		{
+			header.left = header.right = header.parent = nullptr;
+		}
+
+		impl(const Compare& c, node_allocator&& a)
+		:	compare_holder(c), allocator_holder(std::move(a)), count(0)
+		{
+			header.left = header.right = header.parent = nullptr;
+		}
+	} m_;
+
+public:
+	splay_tree() : m_(Compare(), node_allocator()) {}
+
+	explicit splay_tree(const Compare& c, const Alloc& a = Alloc())
+	:	m_(c, node_allocator(a))
+	{}
+
+	explicit splay_tree(const Alloc& a) : m_(Compare(), node_allocator(a)) {}
+
+	splay_tree(const splay_tree& t)
+	:	m_(t.comp(), node_traits::select_on_container_copy_construction(
+															t.nalloc()))
+	{
+		set_root(clone(t.root()));
+		m_.count = t.m_.count;
+	}
+
+	splay_tree(splay_tree&& t)
+		noexcept(std::is_nothrow_copy_constructible<Compare>::value)
+	:	m_(t.comp(), std::move(t.nalloc()))
+	{
+		steal(t);
+	}
+
+	template <typename InputIt>
+	splay_tree(InputIt first, InputIt last,
+				const Compare& c = Compare(), const Alloc& a = Alloc())
+	:	m_(c, node_allocator(a))
+	{
+		insert(first, last);
+	}
+
+	splay_tree(std::initializer_list<value_type> il,
+				const Compare& c = Compare(), const Alloc& a = Alloc())
+	:	m_(c, node_allocator(a))
+	{
+		insert(il.begin(), il.end());
+	}
+
+	~splay_tree() { clear(); }
+
+	splay_tree& operator=(const splay_tree& t)
+	{
+		if (this != &t) {
+			splay_tree u(t);
+			clear();
+			if (node_traits::propagate_on_container_copy_assignment::value)
+				nalloc() = t.nalloc();
+			comp() = t.comp();
+			if (nalloc() == u.nalloc())
+				steal(u);
+			else
+				for (const_iterator i = t.begin(); i != t.end(); ++i)
+					emplace_hint(end(), *i);
+		}
+		return *this;
+	}
+
+	splay_tree& operator=(splay_tree&& t) noexcept(nothrow_move_assign)
+	{
+		if (this != &t) {
+			clear();
+			comp() = t.comp();
+			if (node_traits::propagate_on_container_move_assignment::value) {
+				nalloc() = std::move(t.nalloc());
+				steal(t);
+			}
+			else if (splay_detail::always_equal<node_allocator>::value
+					|| nalloc() == t.nalloc())
+				steal(t);
+			else {
+				for (iterator i = t.begin(); i != t.end(); ++i)
+					try_emplace(i -> first, std::move(i -> second));
+				t.clear();
+			}
+		}
+		return *this;
+	}
+
+	allocator_type get_allocator() const { return allocator_type(nalloc()); }
+	key_compare key_comp() const { return comp(); }
+
+	/* Iteration never splays.  begin() walks the left spine. */
+	iterator begin() { return make_iter(first_node()); }
+	const_iterator begin() const { return make_citer(first_node()); }
+	const_iterator cbegin() const { return begin(); }
+	iterator end() { return make_iter(header()); }
+	const_iterator end() const { return make_citer(header()); }
+	const_iterator cend() const { return end(); }
+	reverse_iterator rbegin() { return reverse_iterator(end()); }
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+	reverse_iterator rend() { return reverse_iterator(begin()); }
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	bool empty() const { return 0 == m_.count; }
+	size_type size() const { return m_.count; }
+	size_type max_size() const { return node_traits::max_size(nalloc()); }
+
+	/* Release every node.  Iterative, by rotating left children upwards, so
+	   even a tree that has degenerated into a long chain is safe. */
+	void clear() noexcept
+	{
+		node_base* n = root();
+		while (n)
+			if (n -> left) {
+				node_base* y = n -> left;
+				n -> left = y -> right;
+				y -> right = n;
+				n = y;
+			}
+			else {
+				node_base* y = n -> right;
+				destroy_node(n);
+				n = y;
+			}
+		set_root(nullptr);
+		m_.count = 0;
+	}
+
+	/** Find key k and splay it to the root; return end() if absent. */
+	iterator find(const K& k)
+	{
+		return found_at_root(k) ? make_iter(root()) : end();
+	}
+
+	/** Find key k without splaying. */
+	const_iterator find(const K& k) const
+	{
+		const_iterator i = lower_bound(k);
+		return i != end() && ! comp()(k, i -> first) ? i : end();
+	}
+
+	size_type count(const K& k) const { return find(k) != end(); }
+
+	/* After splaying for k, the root is either the record with key k, or the
+	   last node of the search path, whose in-order neighbor on the other side
+	   of k is its predecessor or successor.  So one step suffices. */
+
+	/** First record with key not less than k; splays the search path. */
+	iterator lower_bound(const K& k)
+	{
+		if (! root())
+			return end();
+		set_root(splay(root(), k));
+		return comp()(key(root()), k)
+				? make_iter(splay_detail::next_node(root(), header()))
+				: make_iter(root());
+	}
+
+	/** First record with key greater than k; splays the search path. */
+	iterator upper_bound(const K& k)
+	{
+		if (! root())
+			return end();
+		set_root(splay(root(), k));
+		return comp()(k, key(root()))
+				? make_iter(root())
+				: make_iter(splay_detail::next_node(root(), header()));
+	}
+
+	const_iterator lower_bound(const K& k) const
+	{
+		node_base *n = root(), *best = header();
+		while (n)
+			if (comp()(key(n), k))
+				n = n -> right;
+			else {
+				best = n;
+				n = n -> left;
+			}
+		return make_citer(best);
+	}
+
+	const_iterator upper_bound(const K& k) const
+	{
+		node_base *n = root(), *best = header();
+		while (n)
+			if (comp()(k, key(n))) {
+				best = n;
+				n = n -> left;
+			}
+			else
+				n = n -> right;
+		return make_citer(best);
+	}
+
+	V& at(const K& k)
+	{
+		iterator i = find(k);
+		if (i == end())
+			throw std::out_of_range("splay_tree::at");
+		return i -> second;
+	}
+
+	const V& at(const K& k) const
+	{
+		const_iterator i = find(k);
+		if (i == end())
+			throw std::out_of_range("splay_tree::at");
+		return i -> second;
+	}
+
+	V& operator[](const K& k) { return try_emplace(k).first -> second; }
+	V& operator[](K&& k) { return try_emplace(std::move(k)).first -> second; }
+
+	std::pair<iterator, bool> insert(const value_type& v)
+	{
+		return emplace(v);
+	}
+
+	std::pair<iterator, bool> insert(value_type&& v)
+	{
+		return emplace(std::move(v));
+	}
+
+	template <typename InputIt>
+	void insert(InputIt first, InputIt last)
+	{
+		for ( ; first != last; ++first)
+			emplace(*first);
+	}
+
+	/** Construct a record from args; keep it only if its key is new.
+		Either way, the record with that key ends up at the root. */
+	template <typename... Args>
+	std::pair<iterator, bool> emplace(Args&&... args)
+	{
+		node_base* n = create_node(std::forward<Args>(args)...);
+		if (found_at_root(key(n))) {
+			destroy_node(n);
+			return std::make_pair(make_iter(root()), false);
+		}
+		link_as_root(n);
+		return std::make_pair(make_iter(n), true);
+	}
+
+	/* The hint is ignored:  splaying already favors nearby keys. */
+	template <typename... Args>
+	iterator emplace_hint(const_iterator, Args&&... args)
+	{
+		return emplace(std::forward<Args>(args)...).first;
+	}
+
+	/** Like emplace, but construct the value only if key k is new. */
+	template <typename KK, typename... Args>
+	std::pair<iterator, bool> try_emplace(KK&& k, Args&&... args)
+	{
+		if (found_at_root(k))
+			return std::make_pair(make_iter(root()), false);
+
+		node_base* n = create_node(std::piecewise_construct,
+							std::forward_as_tuple(std::forward<KK>(k)),
+							std::forward_as_tuple(std::forward<Args>(args)...));
+		link_as_root(n);
+		return std::make_pair(make_iter(n), true);
+	}
+
+	template <typename M>
+	std::pair<iterator, bool> insert_or_assign(const K& k, M&& m)
+	{
+		std::pair<iterator, bool> r = try_emplace(k, std::forward<M>(m));
+		if (! r.second)
+			r.first -> second = std::forward<M>(m);
+		return r;
+	}
+
+	/** Erase the record at pos; return the position after it. */
+	iterator erase(const_iterator pos)
+	{
+		node_base* n = pos.n_;
+		iterator next = make_iter(splay_detail::next_node(n, header()));
+
+		set_root(splay(root(), key(n)));				/* n is now the root */
+		if (n -> left) {
+			node_base* l = splay_end(n -> left, false);
+			splay_detail::set_right(l, n -> right);
+			set_root(l);
+		}
+		else
+			set_root(n -> right);
+
+		destroy_node(n);
+		m_.count -= 1;
+		return next;
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		while (first != last)
+			first = erase(first);
+		return make_iter(last.n_);
+	}
+
+	size_type erase(const K& k)
+	{
+		iterator i = find(k);
+		if (i == end())
+			return 0;
+		erase(i);
+		return 1;
+	}
+
+	void swap(splay_tree& t)
+	{
+		using std::swap;
+		if (node_traits::propagate_on_container_swap::value)
+			swap(nalloc(), t.nalloc());
+		swap(comp(), t.comp());
+		node_base *a = root(), *b = t.root();
+		set_root(b);
+		t.set_root(a);
+		swap(m_.count, t.m_.count);
+	}
+
+	friend void swap(splay_tree& a, splay_tree& b) { a.swap(b); }
+
+private:
+	Compare& comp() { return m_.compare_holder::get(); }
+	const Compare& comp() const { return m_.compare_holder::get(); }
+	node_allocator& nalloc() { return m_.allocator_holder::get(); }
+	const node_allocator& nalloc() const
+	{
+		return m_.allocator_holder::get();
+	}
+
+	node_base* header() const { return const_cast<node_base*>(&m_.header); }
+	node_base* root() const { return m_.header.parent; }
+
+	void set_root(node_base* n)
+	{
+		m_.header.parent = n;
+		if (n)
+			n -> parent = header();
+	}
+
+	iterator make_iter(node_base* n) { return iterator(n, header()); }
+	const_iterator make_citer(node_base* n) const
+	{
+		return const_iterator(n, header());
+	}
+
+	node_base* first_node() const
+	{
+		return root() ? splay_detail::leftmost(root()) : header();
+	}
+
+	static const K& key(const node_base* n)
+	{
+		return static_cast<const node*>(n) -> valptr() -> first;
+	}
+
+	/* Splay for key k, and report whether the root now has key k. */
+	bool found_at_root(const K& k)
+	{
+		if (! root())
+			return false;
+		set_root(splay(root(), k));
+		return ! comp()(k, key(root())) && ! comp()(key(root()), k);
+	}
+
+	/* Make n the new root, splitting the old tree (already splayed for
+	   n's key, which is absent) between n's subtrees. */
+	void link_as_root(node_base* n)
+	{
+		node_base* r = root();
+		n -> left = n -> right = nullptr;
+		if (r) {
+			if (comp()(key(n), key(r))) {
+				splay_detail::set_left(n, r -> left);
+				r -> left = nullptr;
+				splay_detail::set_right(n, r);
+			}
+			else {
+				splay_detail::set_right(n, r -> right);
+				r -> right = nullptr;
+				splay_detail::set_left(n, r);
+			}
+		}
+		set_root(n);
+		m_.count += 1;
+	}
+
+	/* Top-down splay of the subtree at t for key k.  Returns the new subtree
+	   root, which is the node with key k if present, or else the last node
+	   on the search path.  The caller must set the root's parent. */
+	node_base* splay(node_base* t, const K& k)
+	{
+		using splay_detail::set_left;
+		using splay_detail::set_right;
+		node_base n, *l, *r, *y;
+
+		n.left = n.right = n.parent = nullptr;
+		l = r = &n;
+		for (;;)
+			if (comp()(k, key(t))) {
+				if (! t -> left)
+					break;
+				if (comp()(k, key(t -> left))) {
+					y = t -> left;						/* rotate right */
+					set_left(t, y -> right);
+					set_right(y, t);
+					t = y;
+					if (! t -> left)
+						break;
+				}
+				set_left(r, t);							/* link right */
+				r = t;
+				t = t -> left;
+			}
+			else if (comp()(key(t), k)) {
+				if (! t -> right)
+					break;
+				if (comp()(key(t -> right), k)) {
+					y = t -> right;						/* rotate left */
+					set_right(t, y -> left);
+					set_left(y, t);
+					t = y;
+					if (! t -> right)
+						break;
+				}
+				set_right(l, t);						/* link left */
+				l = t;
+				t = t -> right;
+			}
+			else
+				break;
+
+		set_right(l, t -> left);						/* assemble */
+		set_left(r, t -> right);
+		set_left(t, n.right);
+		set_right(t, n.left);
+		return t;
+	}
+
+	/* Top-down splay of the minimum (or maximum) of the subtree at t. */
+	node_base* splay_end(node_base* t, bool want_min)
+	{
+		using splay_detail::set_left;
+		using splay_detail::set_right;
+		node_base n, *l, *r, *y;
+
+		n.left = n.right = n.parent = nullptr;
+		l = r = &n;
+		if (want_min)
+			while (t -> left) {
+				y = t -> left;
+				if (y -> left) {
+					set_left(t, y -> right);
+					set_right(y, t);
+					t = y;
+					if (! t -> left)
+						break;
+				}
+				set_left(r, t);
+				r = t;
+				t = t -> left;
+			}
+		else
+			while (t -> right) {
+				y = t -> right;
+				if (y -> right) {
+					set_right(t, y -> left);
+					set_left(y, t);
+					t = y;
+					if (! t -> right)
+						break;
+				}
+				set_right(l, t);
+				l = t;
+				t = t -> right;
+			}
+
+		set_right(l, t -> left);
+		set_left(r, t -> right);
+		set_left(t, n.right);
+		set_right(t, n.left);
+		return t;
+	}
+
+	template <typename... Args>
+	node_base* create_node(Args&&... args)
+	{
+		node* n = node_traits::allocate(nalloc(), 1);
+		::new (static_cast<void*>(n)) node;
+		try {
+			node_traits::construct(nalloc(), n -> valptr(),
+									std::forward<Args>(args)...);
+		}
+		catch (...) {
+			node_traits::deallocate(nalloc(), n, 1);
+			throw;
+		}
+		n -> left = n -> right = n -> parent = nullptr;
+		return n;
+	}
+
+	void destroy_node(node_base* b)
+	{
+		node* n = static_cast<node*>(b);
+		node_traits::destroy(nalloc(), n -> valptr());
+		node_traits::deallocate(nalloc(), n, 1);
+	}
+
+	/* Deep copy of the subtree at src, preserving its shape.  Iterative,
+	   climbing back up by the parent pointers of both trees. */
+	node_base* clone(const node_base* src)
+	{
+		using splay_detail::set_left;
+		using splay_detail::set_right;
+
+		if (! src)
+			return nullptr;
+
+		node_base* dst = create_node(*static_cast<const node*>(src)->valptr());
+		node_base* d = dst;
+		const node_base* s = src;
+		try {
+			for (;;)
+				if (s -> left && ! d -> left) {
+					set_left(d, create_node(
+							*static_cast<const node*>(s -> left) -> valptr()));
+					s = s -> left;
+					d = d -> left;
+				}
+				else if (s -> right && ! d -> right) {
+					set_right(d, create_node(
+							*static_cast<const node*>(s -> right) -> valptr()));
+					s = s -> right;
+					d = d -> right;
+				}
+				else if (s == src)
+					break;
+				else {
+					s = s -> parent;
+					d = d -> parent;
+				}
+		}
+		catch (...) {
+			splay_tree u(comp(), allocator_type(nalloc()));
+			u.set_root(dst);
+			throw;
+		}
+		return dst;
+	}
+
+	/* Take the contents of t, which must use an equal allocator. */
+	void steal(splay_tree& t)
+	{
+		set_root(t.root());
+		m_.count = t.m_.count;
+		t.set_root(nullptr);
+		t.m_.count = 0;
+	}
+};
+
+} // end namespace predoehl
+
+#endif